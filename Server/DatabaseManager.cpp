@@ -5,13 +5,24 @@
 DatabaseManager* DatabaseManager::instance_ = nullptr;
 mutex DatabaseManager::mutex_;
 
-DatabaseManager::DatabaseManager() : connection_(nullptr) {
-    // 初始化MySQL库
-    mysql_library_init(0, nullptr, nullptr);
-    connection_ = mysql_init(nullptr);
-    if (connection_ == nullptr) {
-        cerr << "MySQL initialization failed" << endl;
+namespace {
+// 线程私有的MySQL连接，线程退出时自动关闭
+struct ThreadConnection {
+    MYSQL* mysql = nullptr;
+    ~ThreadConnection() {
+        if (mysql != nullptr) {
+            mysql_close(mysql);
+            mysql = nullptr;
+        }
+        mysql_thread_end();
     }
+};
+thread_local ThreadConnection t_connection;
+}
+
+DatabaseManager::DatabaseManager() {
+    // 初始化MySQL库（必须在创建其他线程之前调用）
+    mysql_library_init(0, nullptr, nullptr);
 }
 
 DatabaseManager::~DatabaseManager() {
@@ -29,24 +40,45 @@ DatabaseManager* DatabaseManager::getInstance() {
     return instance_;
 }
 
-bool DatabaseManager::initializeConnection(const string& host, const string& user, const string& password, const string& database) {
-    if (connection_ == nullptr) {
-        connection_ = mysql_init(nullptr);
-        if (connection_ == nullptr) {
-            return false;
-        }
+MYSQL* DatabaseManager::openConnection(const string& host, const string& user, const string& password, const string& database) {
+    MYSQL* conn = mysql_init(nullptr);
+    if (conn == nullptr) {
+        cerr << "MySQL initialization failed" << endl;
+        return nullptr;
     }
     
     // 设置连接选项
-    mysql_options(connection_, MYSQL_SET_CHARSET_NAME, "utf8mb4");
+    mysql_options(conn, MYSQL_SET_CHARSET_NAME, "utf8mb4");
     
-    if (!mysql_real_connect(connection_, host.c_str(), user.c_str(), password.c_str(), 
+    if (!mysql_real_connect(conn, host.c_str(), user.c_str(), password.c_str(), 
                            database.c_str(), 3306, nullptr, 0)) {
-        cerr << "MySQL connection failed: " << mysql_error(connection_) << endl;
-        return false;
+        cerr << "MySQL connection failed: " << mysql_error(conn) << endl;
+        mysql_close(conn);
+        return nullptr;
     }
     
-    return true;
+    return conn;
+}
+
+bool DatabaseManager::initializeConnection(const string& host, const string& user, const string& password, const string& database) {
+    // 保存连接参数，供其他线程首次访问时建立连接
+    host_ = host;
+    user_ = user;
+    password_ = password;
+    database_ = database;
+    
+    // 为当前线程建立连接，同时验证参数是否可用
+    disconnect();
+    t_connection.mysql = openConnection(host, user, password, database);
+    return t_connection.mysql != nullptr;
+}
+
+MYSQL* DatabaseManager::connection() const {
+    if (t_connection.mysql == nullptr && !host_.empty()) {
+        // 当前线程首次访问数据库时按保存的参数建立连接
+        t_connection.mysql = openConnection(host_, user_, password_, database_);
+    }
+    return t_connection.mysql;
 }
 
 bool DatabaseManager::connect(const string& host, const string& user, const string& password, const string& database) {
@@ -54,36 +86,45 @@ bool DatabaseManager::connect(const string& host, const string& user, const stri
 }
 
 void DatabaseManager::disconnect() {
-    if (connection_ != nullptr) {
-        mysql_close(connection_);
-        connection_ = nullptr;
+    if (t_connection.mysql != nullptr) {
+        mysql_close(t_connection.mysql);
+        t_connection.mysql = nullptr;
     }
 }
 
 bool DatabaseManager::isConnected() const {
-    return connection_ != nullptr && mysql_ping(connection_) == 0;
+    MYSQL* conn = connection();
+    return conn != nullptr && mysql_ping(conn) == 0;
 }
 
 json DatabaseManager::executeQuery(const string& query, const vector<string>& params) {
     json result;
+    queryEach(query, params, [&result](json& row) {
+        result.push_back(std::move(row));
+        return true;
+    });
+    return result;
+}
+
+bool DatabaseManager::queryEach(const string& query, const vector<string>& params, const RowCallback& on_row) {
     
     if (!isConnected()) {
         cerr << "Not connected to database" << endl;
-        return result;
+        return false;
     }
     
     // 创建预处理语句
-    MYSQL_STMT* stmt = mysql_stmt_init(connection_);
+    MYSQL_STMT* stmt = mysql_stmt_init(connection());
     if (stmt == nullptr) {
         cerr << "mysql_stmt_init failed" << endl;
-        return result;
+        return false;
     }
     
     // 准备预处理语句
     if (mysql_stmt_prepare(stmt, query.c_str(), query.length()) != 0) {
         cerr << "mysql_stmt_prepare failed: " << mysql_stmt_error(stmt) << endl;
         mysql_stmt_close(stmt);
-        return result;
+        return false;
     }
     
     // 绑定参数
@@ -91,7 +132,7 @@ json DatabaseManager::executeQuery(const string& query, const vector<string>& pa
     if (param_count != params.size()) {
         cerr << "Parameter count mismatch: expected " << param_count << ", got " << params.size() << endl;
         mysql_stmt_close(stmt);
-        return result;
+        return false;
     }
     
     if (param_count > 0) {
@@ -110,7 +151,7 @@ json DatabaseManager::executeQuery(const string& query, const vector<string>& pa
         if (mysql_stmt_bind_param(stmt, bind.data()) != 0) {
             cerr << "mysql_stmt_bind_param failed: " << mysql_stmt_error(stmt) << endl;
             mysql_stmt_close(stmt);
-            return result;
+            return false;
         }
     }
     
@@ -118,7 +159,7 @@ json DatabaseManager::executeQuery(const string& query, const vector<string>& pa
     if (mysql_stmt_execute(stmt) != 0) {
         cerr << "mysql_stmt_execute failed: " << mysql_stmt_error(stmt) << endl;
         mysql_stmt_close(stmt);
-        return result;
+        return false;
     }
     
     // 获取结果集元数据
@@ -126,7 +167,7 @@ json DatabaseManager::executeQuery(const string& query, const vector<string>& pa
     if (meta_result == nullptr) {
         // 可能是UPDATE/DELETE等没有结果集的语句
         mysql_stmt_close(stmt);
-        return result;
+        return true;
     }
     
     int num_fields = mysql_num_fields(meta_result);
@@ -163,10 +204,11 @@ json DatabaseManager::executeQuery(const string& query, const vector<string>& pa
         for (auto& buffer : buffers) {
             delete[] buffer;
         }
-        return result;
+        return false;
     }
     
-    // 获取结果
+    // 逐行获取结果：未调用mysql_stmt_store_result，行在读取时才从服务器取回，不会整表缓存在客户端
+    bool completed = true;
     while (mysql_stmt_fetch(stmt) == 0) {
         json row;
         for (int i = 0; i < num_fields; ++i) {
@@ -176,7 +218,11 @@ json DatabaseManager::executeQuery(const string& query, const vector<string>& pa
                 row[field_names[i]] = string(buffers[i], lengths[i]);
             }
         }
-        result.push_back(row);
+        if (!on_row(row)) {
+            // 调用方中止，剩余的行由mysql_stmt_close丢弃
+            completed = false;
+            break;
+        }
     }
     
     // 清理资源
@@ -187,7 +233,7 @@ json DatabaseManager::executeQuery(const string& query, const vector<string>& pa
         delete[] buffer;
     }
     
-    return result;
+    return completed;
 }
 
 int DatabaseManager::executeUpdate(const string& query, const vector<string>& params) {
@@ -197,7 +243,7 @@ int DatabaseManager::executeUpdate(const string& query, const vector<string>& pa
     }
     
     // 创建预处理语句
-    MYSQL_STMT* stmt = mysql_stmt_init(connection_);
+    MYSQL_STMT* stmt = mysql_stmt_init(connection());
     if (stmt == nullptr) {
         cerr << "mysql_stmt_init failed" << endl;
         return -1;
@@ -257,17 +303,17 @@ int DatabaseManager::executeUpdate(const string& query, const vector<string>& pa
 // 事务支持方法
 bool DatabaseManager::beginTransaction() {
     if (!isConnected()) return false;
-    return mysql_query(connection_, "START TRANSACTION") == 0;
+    return mysql_query(connection(), "START TRANSACTION") == 0;
 }
 
 bool DatabaseManager::commitTransaction() {
     if (!isConnected()) return false;
-    return mysql_query(connection_, "COMMIT") == 0;
+    return mysql_query(connection(), "COMMIT") == 0;
 }
 
 bool DatabaseManager::rollbackTransaction() {
     if (!isConnected()) return false;
-    return mysql_query(connection_, "ROLLBACK") == 0;
+    return mysql_query(connection(), "ROLLBACK") == 0;
 }
 
 // 特定功能的安全查询方法
@@ -422,6 +468,15 @@ json DatabaseManager::getStudentList() {
     return executeQuery("SELECT * FROM studentinfo ORDER BY number", params);
 }
 
+bool DatabaseManager::streamStudentList(const string& after, size_t limit, const RowCallback& on_row) {
+    // 以上一批最后的学号为游标（学号唯一），不用OFFSET，越往后读也不会越慢
+    string limit_clause = " ORDER BY number LIMIT " + std::to_string(limit);
+    if (after.empty()) {
+        return queryEach("SELECT * FROM studentinfo" + limit_clause, vector<string>(), on_row);
+    }
+    return queryEach("SELECT * FROM studentinfo WHERE number > ?" + limit_clause, {after}, on_row);
+}
+
 json DatabaseManager::searchStudent(const string& keyword) {
     vector<string> params = {"%" + keyword + "%", "%" + keyword + "%"};
     string query = "SELECT * FROM studentinfo WHERE name LIKE ? OR number LIKE ?";
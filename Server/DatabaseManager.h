@@ -3,15 +3,23 @@
 #include <vector>
 #include <mysql/mysql.h>
 #include <mutex>
+#include <functional>
 #include "json.hpp"
 using json = nlohmann::json;
 using namespace std;
 class DatabaseManager{
 private:
-  MYSQL* connection_;
+  // 连接参数，connect时保存，各线程按需建立自己的连接
+  string host_;
+  string user_;
+  string password_;
+  string database_;
   static DatabaseManager* instance_;
   DatabaseManager();
   bool initializeConnection(const string& host,const string& user,const string& password,const string& database);
+  // 获取当前线程的MySQL连接，MYSQL句柄不能被多个线程同时使用，每个线程独立持有一个
+  MYSQL* connection() const;
+  static MYSQL* openConnection(const string& host,const string& user,const string& password,const string& database);
   static mutex mutex_;
 public:
 // 批量导入学生数据，带有进度回调
@@ -22,7 +30,12 @@ public:
                 const std::string& password = "", const std::string& database = "students");
   void disconnect();
   bool isConnected() const;
+  // 逐行处理查询结果的回调，返回false中止读取（row可以被移走）
+  typedef std::function<bool(json& row)> RowCallback;
   json executeQuery(const string& query,const vector<string>& params={});
+  // 逐行读取查询结果，行从MySQL游标读出后立即交给on_row，不在内存中累积整个结果集；
+  // 查询失败或被on_row中止时返回false
+  bool queryEach(const string& query,const vector<string>& params,const RowCallback& on_row);
   int executeUpdate(const string& query,const vector<string>& params={});
 
   // 事务支持
@@ -35,6 +48,9 @@ public:
     json authenticateUser(const std::string& username, const std::string& password);
     json getUserPermissions(const std::string& username);
     json getStudentList();
+    // 按学号顺序逐行读取学号在after之后（after为空时从头开始）的至多limit个学生，用于分批流式返回大结果集；
+    // 每批是独立的查询，批次之间不占用MySQL连接，可以在不同的线程中读取
+    bool streamStudentList(const string& after, size_t limit, const RowCallback& on_row);
     json searchStudent(const std::string& keyword);
     json getStudentDetail(const std::string& studentId);
     bool addStudent(const json& studentData);
@@ -3,11 +3,95 @@
 #include <iostream>
 #include "json.hpp"
 #include "asy.h" // 添加异步任务管理器头文件
+#include "DatabaseManager.h"
+#include "response_stream.h"
+#include "request_schema.h"
+#include "reliable_msg_manager.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_set>
 
 using json = nlohmann::json;
 
 EnhancedBusinessHandler* EnhancedBusinessHandler::instance = nullptr;
 
+// 批量请求的服务号和一帧中最多携带的子请求数
+static const uint16_t BATCH_SERVER_ID = 4001;
+static const size_t MAX_BATCH_REQUESTS = 32;
+
+// 子请求没有独立的连接上下文（不能流式返回），处理函数收到的conn_id为此值
+static const int BATCH_CONN_ID = -1;
+
+// 只读的服务，批量请求中相邻的只读子请求可以并行执行；写操作按顺序单独执行
+static const std::unordered_set<uint16_t> parallelSafeServices = { 1002, 1006, 2001, 2002, 2003, 3002 };
+
+// 各服务请求中data对象的模式，解码器据此在解析时一并校验
+static void registerRequestSchemas() {
+    // 登录的用户名和密码不设为必填：缺少时按空字符串交给UserService，回复原有的"用户名和密码不能为空"
+    registerRequestSchema(1001, RequestSchema()
+        .optional("username", SCHEMA_STRING, 64)
+        .optional("password", SCHEMA_STRING, 128));
+    registerRequestSchema(1003, RequestSchema()
+        .required("username", SCHEMA_STRING, 64)
+        .required("password", SCHEMA_STRING, 128)
+        .required("realName", SCHEMA_STRING, 64)
+        .optional("role", SCHEMA_STRING, 32)
+        .optional("isActive", SCHEMA_BOOLEAN));
+    registerRequestSchema(1004, RequestSchema()
+        .required("id", SCHEMA_INTEGER)
+        .required("username", SCHEMA_STRING, 64)
+        .required("password", SCHEMA_STRING, 128)
+        .required("realName", SCHEMA_STRING, 64)
+        .required("role", SCHEMA_STRING, 32)
+        .required("isActive", SCHEMA_BOOLEAN));
+    registerRequestSchema(1005, RequestSchema()
+        .required("userId", SCHEMA_INTEGER));
+
+    registerRequestSchema(2001, RequestSchema()
+        .optional("page", SCHEMA_INTEGER)
+        .optional("pageSize", SCHEMA_INTEGER)
+        .optional("stream", SCHEMA_BOOLEAN)
+        .optional("chunkRows", SCHEMA_INTEGER));
+    registerRequestSchema(2002, RequestSchema()
+        .optional("keyword", SCHEMA_STRING, 256));
+    registerRequestSchema(2003, RequestSchema()
+        .required("studentId", SCHEMA_INTEGER));
+
+    // 学生信息字段，新增时只有学号和姓名必填，更新时全部必填
+    const char* studentFields[] = { "gender", "birthday", "phone", "email", "department",
+                                    "major", "className", "enrollmentDate", "status" };
+    RequestSchema addStudent;
+    addStudent.required("studentId", SCHEMA_STRING, 32)
+              .required("name", SCHEMA_STRING, 64);
+    RequestSchema updateStudent;
+    updateStudent.required("id", SCHEMA_INTEGER)
+                 .required("studentId", SCHEMA_STRING, 32)
+                 .required("name", SCHEMA_STRING, 64);
+    for (const char* field : studentFields) {
+        addStudent.optional(field, SCHEMA_STRING, 128);
+        updateStudent.required(field, SCHEMA_STRING, 128);
+    }
+    registerRequestSchema(2004, addStudent);
+    registerRequestSchema(2005, updateStudent);
+    registerRequestSchema(2006, RequestSchema()
+        .required("studentId", SCHEMA_INTEGER));
+
+    registerRequestSchema(3001, RequestSchema()
+        .optional("operationType", SCHEMA_STRING, 64));
+    registerRequestSchema(3002, RequestSchema()
+        .required("taskId", SCHEMA_STRING, 64));
+    registerRequestSchema(3003, RequestSchema()
+        .required("taskId", SCHEMA_STRING, 64));
+    registerRequestSchema(3004, RequestSchema()
+        .optional("count", SCHEMA_INTEGER));
+    registerRequestSchema(3005, RequestSchema()
+        .required("students", SCHEMA_ARRAY, 10000));
+
+    registerRequestSchema(BATCH_SERVER_ID, RequestSchema()
+        .required("requests", SCHEMA_ARRAY, MAX_BATCH_REQUESTS));
+}
+
 EnhancedBusinessHandler::EnhancedBusinessHandler() {
     userService = UserService::getInstance();
     studentService = StudentService::getInstance();
@@ -55,6 +139,22 @@ void EnhancedBusinessHandler::initialize(BusinessHandler* handler) {
         handler->registerHandler(3003, std::bind(&EnhancedBusinessHandler::handleCancelTask, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
         handler->registerHandler(3004, std::bind(&EnhancedBusinessHandler::handleBatchProcessStudents, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
         handler->registerHandler(3005, std::bind(&EnhancedBusinessHandler::handleBatchImportStudents, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+        
+        // 注册批量请求处理器
+        handler->registerHandler(BATCH_SERVER_ID, std::bind(&EnhancedBusinessHandler::handleBatch, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+        
+        registerRequestSchemas();
+        
+        // 热点接口的消息体不构建json DOM，由处理函数直接解码为类型化请求
+        registerRawBodyService(1001);
+        registerRawBodyService(2001);
+        registerRawBodyService(2002);
+        registerRawBodyService(2003);
+        
+        // 只读接口的响应最多发送一次，丢失时客户端重新请求；写操作保持默认的可靠投递
+        for (uint16_t server : parallelSafeServices) {
+            registerServiceDelivery(server, DeliveryClass::AT_MOST_ONCE);
+        }
     }
 }
 
@@ -218,6 +318,152 @@ void EnhancedBusinessHandler::handleBatchProcessStudents(int conn_id, MyProtoMsg
     }
 }
 
+// 批量请求：data.requests中每一项为{"serverId": 服务号, "data": 请求数据}，
+// 子请求走正常的分发流程，相邻的只读子请求并行执行，所有结果按原顺序合并为一个响应
+void EnhancedBusinessHandler::handleBatch(int conn_id, MyProtoMsg& msg, MyProtoMsg& response) {
+    json request = parseRequestBody(msg);
+    const json& items = request["requests"];
+    size_t count = items.size();
+    
+    std::vector<MyProtoMsg> requests(count);
+    std::vector<MyProtoMsg> responses(count);
+    std::vector<bool> prepared(count, false);
+    for (size_t i = 0; i < count; ++i) {
+        std::string error;
+        prepared[i] = prepareBatchItem(msg, items[i], requests[i], error);
+        if (!prepared[i]) {
+            responses[i].body = { {"success", false}, {"message", error} };
+        }
+    }
+    
+    // 按顺序执行：连续的只读子请求组成一组并行执行，遇到写操作先等前面的组完成再单独执行
+    size_t i = 0;
+    while (i < count) {
+        std::vector<size_t> group;
+        while (i < count && (!prepared[i] || parallelSafeServices.count(requests[i].head.server))) {
+            if (prepared[i]) {
+                group.push_back(i);
+            }
+            ++i;
+        }
+        runBatchGroup(group, requests, responses);
+        if (i < count) {
+            businessHandler->handleMessage(BATCH_CONN_ID, requests[i], responses[i]);
+            ++i;
+        }
+    }
+    
+    json results = json::array();
+    for (size_t k = 0; k < count; ++k) {
+        json item = std::move(responses[k].body);
+        if (!item.is_object()) {
+            item = { {"success", false}, {"message", "Empty response"} };
+        }
+        item["serverId"] = items[k].is_object() ? items[k].value("serverId", json()) : json();
+        results.push_back(std::move(item));
+    }
+    
+    json result;
+    result["success"] = true;
+    result["message"] = "Batch processed: " + std::to_string(count) + " requests";
+    result["results"] = std::move(results);
+    setResponse(result, response);
+}
+
+bool EnhancedBusinessHandler::prepareBatchItem(const MyProtoMsg& batch, const json& item, MyProtoMsg& sub, std::string& error) {
+    if (!item.is_object()) {
+        error = "Batch item must be an object";
+        return false;
+    }
+    auto server = item.find("serverId");
+    if (server == item.end() || !server->is_number_integer() ||
+        server->get<int64_t>() <= 0 || server->get<int64_t>() > 0xFFFF) {
+        error = "Batch item requires a valid serverId";
+        return false;
+    }
+    uint16_t serverId = (uint16_t)server->get<int64_t>();
+    if (serverId == BATCH_SERVER_ID) {
+        error = "Nested batch requests are not allowed";
+        return false;
+    }
+    
+    // 子请求沿用批量请求的消息头，消息体按普通请求的形式组装：顶层userId，data为子请求数据
+    sub.head = batch.head;
+    sub.head.server = serverId;
+    sub.head.flags = MY_PROTO_CODEC_JSON;
+    json body = json::object();
+    auto userId = batch.body.find("userId");
+    if (userId != batch.body.end()) {
+        body["userId"] = *userId;
+    }
+    auto data = item.find("data");
+    if (data != item.end()) {
+        body["data"] = *data;
+    }
+    
+    // 与解码器相同的规则：按子服务的请求模式校验，热点服务保留原始字节由处理函数直接解码
+    std::string text = body.dump();
+    bool raw = isRawBodyService(serverId);
+    if (!validateRequestBody((const uint8_t*)text.data(), text.size(), MY_PROTO_CODEC_JSON,
+                             findRequestSchema(serverId), raw ? nullptr : &sub.body, error)) {
+        return false;
+    }
+    if (raw) {
+        sub.rawBody = std::move(text);
+    }
+    return true;
+}
+
+void EnhancedBusinessHandler::runBatchGroup(const std::vector<size_t>& group, std::vector<MyProtoMsg>& requests, std::vector<MyProtoMsg>& responses) {
+    if (group.empty()) {
+        return;
+    }
+    if (group.size() == 1) {
+        businessHandler->handleMessage(BATCH_CONN_ID, requests[group[0]], responses[group[0]]);
+        return;
+    }
+    
+    struct GroupState {
+        std::atomic<size_t> next{ 0 };
+        size_t total = 0;
+        size_t done = 0;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    std::shared_ptr<GroupState> state = std::make_shared<GroupState>();
+    state->total = group.size();
+    
+    // 领取到下标的一方才会访问group和请求，当前线程会等到全部完成，
+    // 线程池中晚到的协助任务领取不到下标直接返回，不会访问已经失效的引用
+    BusinessHandler* handler = businessHandler;
+    auto work = [state, handler, &group, &requests, &responses]() {
+        size_t k;
+        while ((k = state->next++) < state->total) {
+            size_t index = group[k];
+            try {
+                handler->handleMessage(BATCH_CONN_ID, requests[index], responses[index]);
+            } catch (...) {
+                responses[index].body = { {"success", false}, {"message", "Exception in batch item"} };
+            }
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (++state->done == state->total) {
+                state->finished.notify_one();
+            }
+        }
+    };
+    
+    // 线程池不可用时协助任务提交失败，由当前线程独自完成
+    for (size_t k = 1; k < group.size(); ++k) {
+        if (!businessHandler->submitTask(work)) {
+            break;
+        }
+    }
+    work();
+    
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&state]() { return state->done == state->total; });
+}
+
 bool EnhancedBusinessHandler::forwardMessage(int conn_id, MyProtoMsg& msg) {
     if (businessHandler) {
         return businessHandler->handleMessage(conn_id, msg);
@@ -225,11 +471,19 @@ bool EnhancedBusinessHandler::forwardMessage(int conn_id, MyProtoMsg& msg) {
     return false;
 }
 
-json EnhancedBusinessHandler::parseRequestBody(const MyProtoMsg& msg) {
+json EnhancedBusinessHandler::parseRequestBody(MyProtoMsg& msg) {
     try {
-        // 从msg.body中解析JSON
-        if (msg.body.count("data")) {
-            return json::parse(msg.body["data"]);
+        auto it = msg.body.find("data");
+        if (it == msg.body.end()) {
+            return json::object();
+        }
+        // v2的data已经是解码好的对象，直接移出，不再二次解析
+        if (it->is_object() || it->is_array()) {
+            return std::move(*it);
+        }
+        // v1的data是JSON字符串
+        if (it->is_string()) {
+            return json::parse(it->get_ref<const std::string&>());
         }
         return json::object();
     } catch (...) {
@@ -238,7 +492,12 @@ json EnhancedBusinessHandler::parseRequestBody(const MyProtoMsg& msg) {
 }
 
 void EnhancedBusinessHandler::setResponse(const json& result, MyProtoMsg& response) {
-    response.body["data"] = result.dump();
+    // 响应版本与请求一致（BusinessHandler在调用处理函数前已设置），v2直接嵌套，v1仍序列化为字符串
+    if (response.head.version >= MY_PROTO_VERSION_NESTED_DATA) {
+        response.body["data"] = result;
+    } else {
+        response.body["data"] = result.dump();
+    }
     response.body["success"] = result.contains("success") ? result["success"].get<bool>() : false;
     if (result.contains("message")) {
         response.body["message"] = result["message"].get<std::string>();
@@ -254,11 +513,12 @@ int EnhancedBusinessHandler::getCurrentUserId(const MyProtoMsg& msg) {
 }
 
 void EnhancedBusinessHandler::handleLogin(int conn_id, MyProtoMsg& msg, MyProtoMsg& response) {
-    json request = parseRequestBody(msg);
-    std::string username = request.contains("username") ? request["username"] : "";
-    std::string password = request.contains("password") ? request["password"] : "";
+    LoginRequest request;
+    if (!decodeTypedBody(msg, request, response)) {
+        return;
+    }
     
-    json result = userService->login(username, password);
+    json result = userService->login(request.username, request.password);
     setResponse(result, response);
 }
 
@@ -269,30 +529,53 @@ void EnhancedBusinessHandler::handleGetUserPermissions(int conn_id, MyProtoMsg&
 }
 
 void EnhancedBusinessHandler::handleGetStudentList(int conn_id, MyProtoMsg& msg, MyProtoMsg& response) {
-    json request = parseRequestBody(msg);
-    int page = request.contains("page") ? request["page"] : 1;
-    int pageSize = request.contains("pageSize") ? request["pageSize"] : 10;
-    int userId = getCurrentUserId(msg);
+    StudentListRequest request;
+    if (!decodeTypedBody(msg, request, response)) {
+        return;
+    }
+    int userId = request.userId;
+    
+    // 流式模式：返回全部学生，边从数据库读取边按分片发送，最终响应作为结束标记
+    if (request.stream) {
+        if (conn_id == BATCH_CONN_ID) {
+            setResponse({ {"success", false}, {"message", "Streaming is not supported in batch requests"} }, response);
+            return;
+        }
+        // 游标保存在数据源中，后续批次在工作线程池中从游标处继续读取
+        StudentService* service = studentService;
+        std::string after;
+        std::shared_ptr<ResponseStream> stream = ResponseStream::create(businessHandler, conn_id, msg,
+            [this](const json& result, MyProtoMsg& frame) { setResponse(result, frame); },
+            [service, userId, after](size_t limit, const std::function<void(json& row)>& on_row, std::string& message) mutable {
+                json result = service->streamStudentList(userId, after, limit, on_row);
+                message = result.value("message", "");
+                return result.value("success", false);
+            }, request.chunkRows);
+        stream->start(response);
+        return;
+    }
     
-    json result = studentService->getStudentList(page, pageSize, userId);
+    json result = studentService->getStudentList(request.page, request.pageSize, userId);
     setResponse(result, response);
 }
 
 void EnhancedBusinessHandler::handleSearchStudent(int conn_id, MyProtoMsg& msg, MyProtoMsg& response) {
-    json request = parseRequestBody(msg);
-    std::string keyword = request.contains("keyword") ? request["keyword"] : "";
-    int userId = getCurrentUserId(msg);
+    StudentSearchRequest request;
+    if (!decodeTypedBody(msg, request, response)) {
+        return;
+    }
     
-    json result = studentService->searchStudent(keyword, userId);
+    json result = studentService->searchStudent(request.keyword, request.userId);
     setResponse(result, response);
 }
 
 void EnhancedBusinessHandler::handleGetStudentDetail(int conn_id, MyProtoMsg& msg, MyProtoMsg& response) {
-    json request = parseRequestBody(msg);
-    int studentId = request.contains("studentId") ? request["studentId"] : 0;
-    int userId = getCurrentUserId(msg);
+    StudentDetailRequest request;
+    if (!decodeTypedBody(msg, request, response)) {
+        return;
+    }
     
-    json result = studentService->getStudentDetail(studentId, userId);
+    json result = studentService->getStudentDetail(request.studentId, request.userId);
     setResponse(result, response);
 }
 
@@ -2,8 +2,10 @@
 #include "business_handler.h"
 #include "UserService.h"
 #include "studentService.h"
+#include "typed_request.h"
 
 #include <functional>
+#include <vector>
 
 class EnhancedBusinessHandler {
 private:
@@ -25,17 +27,35 @@ private:
     void handleUpdateUser(int conn_id, MyProtoMsg& msg, MyProtoMsg& response);
     void handleDeleteUser(int conn_id, MyProtoMsg& msg, MyProtoMsg& response);
     void handleGetAllUsers(int conn_id, MyProtoMsg& msg, MyProtoMsg& response);
-    void handleBatchImportStudents(int conn_id, MyProtoMsg& msg, MyProtoMsg& response)
+    void handleBatchImportStudents(int conn_id, MyProtoMsg& msg, MyProtoMsg& response);
     // 异步任务相关处理函数
     void handleSubmitLongTask(int conn_id, MyProtoMsg& msg, MyProtoMsg& response);
     void handleGetTaskStatus(int conn_id, MyProtoMsg& msg, MyProtoMsg& response);
     void handleCancelTask(int conn_id, MyProtoMsg& msg, MyProtoMsg& response);
     void handleBatchProcessStudents(int conn_id, MyProtoMsg& msg, MyProtoMsg& response);
+    // 批量请求：一帧中携带多个子请求，合并为一个响应返回
+    void handleBatch(int conn_id, MyProtoMsg& msg, MyProtoMsg& response);
     
     // 辅助方法
-    nlohmann::json parseRequestBody(const MyProtoMsg& msg);
+    // 取出请求数据：v2请求的data直接是嵌套对象（会从msg中移出），v1请求的data是JSON字符串
+    nlohmann::json parseRequestBody(MyProtoMsg& msg);
+    // 填充响应：按响应的协议版本决定data写成嵌套对象还是JSON字符串
     void setResponse(const nlohmann::json& result, MyProtoMsg& response);
     int getCurrentUserId(const MyProtoMsg& msg);
+    // 把批量请求中的一项构造成独立的子请求，并按子服务的请求模式校验
+    bool prepareBatchItem(const MyProtoMsg& batch, const nlohmann::json& item, MyProtoMsg& sub, std::string& error);
+    // 并行执行一组只读子请求：当前线程与提交到线程池的协助任务一起领取，返回时全部完成
+    void runBatchGroup(const std::vector<size_t>& group, std::vector<MyProtoMsg>& requests, std::vector<MyProtoMsg>& responses);
+    // 热点接口的请求由SAX直接解码为类型化结构体，失败时填充错误响应并返回false
+    template <typename Request>
+    bool decodeTypedBody(const MyProtoMsg& msg, Request& request, MyProtoMsg& response) {
+        std::string error;
+        if (decodeRequest(msg, request, error)) {
+            return true;
+        }
+        setResponse({ {"success", false}, {"message", error} }, response);
+        return false;
+    }
     
     EnhancedBusinessHandler();
 
@@ -1,4 +1,6 @@
 #include "MyProto.h"
+#include "body_compression.h"
+#include "request_schema.h"
 #include <iostream>
 #include <stdlib.h>
 #include <iomanip>
@@ -24,23 +26,22 @@ const uint32_t SEQUENCE_OFFSET = 9;   // 
 const uint32_t TYPE_OFFSET = 13;      // Ϣֶƫ
 
 // CRC㺯ʵ
-// ʹCRC-16/CCITT-FALSE㷨
+// ʹCRC-16/CCITT-FALSE㷨ʵּcrc16.cpp
 uint16_t calculateCRC(const uint8_t* data, size_t length) {
-    uint16_t crc = CRC_INITIAL_VALUE; // ʼֵ
-    uint16_t polynomial = CRC_POLYNOMIAL; // ʽ
-
-    for (size_t i = 0; i < length; i++) {
-        crc ^= (uint16_t)(data[i] << 8);
-        for (uint8_t j = 0; j < 8; j++) {
-            if (crc & 0x8000)
-                crc = (crc << 1) ^ polynomial;
-            else
-                crc <<= 1;
-        }
-    }
+    return updateCRC(CRC_INITIAL_VALUE, data, length);
+}
+
+// Ϣҵֱӽķţʱעᣬֻ֮
+static bool rawBodyServices[65536] = { false };
 
-    return crc;
+void registerRawBodyService(uint16_t server) {
+    rawBodyServices[server] = true;
 }
+
+bool isRawBodyService(uint16_t server) {
+    return rawBodyServices[server];
+}
+
 //--------------------------------------------------------------------
 //ӡЭϢ
 void printMyProtoMsg(MyProtoMsg& msg)
@@ -72,43 +73,135 @@ void MyProtoEncode::headEncode(uint8_t* pData, MyProtoMsg* pMsg) {
     *(uint32_t*)(pData + SEQUENCE_OFFSET) = htonl(pMsg->head.sequence);
 
     // type - 1ֽ
-    *(pData + TYPE_OFFSET) = pMsg->head.type;
+    *(pData + TYPE_OFFSET) = (pMsg->head.type & MY_PROTO_TYPE_MASK) | (pMsg->head.flags & MY_PROTO_FLAG_MASK);
 }
 
 //ЭϢװpMsgֻвݣJsonЭ壬ţ汾ţǶϢ޸ĳϢʱҪ±Э
 //lenسϢںsocket
 uint8_t* MyProtoEncode::encode(MyProtoMsg* pMsg, uint32_t& len)
 {
-    uint8_t* pData = NULL;
-    string bodyStr = pMsg->body.dump();
+    string frame;
+    if (!encode(pMsg, frame)) {
+        len = 0;
+        return NULL;
+    }
 
-    // ϢлԺ³
-    len = MY_PROTO_HEAD_SIZE + (uint32_t)bodyStr.size();
-    pMsg->head.len = len;
+    len = (uint32_t)frame.size();
+    uint8_t* pData = new uint8_t[len];
+    memcpy(pData, frame.data(), len);
+    return pData;
+}
+
+//뵽÷ṩĻϢлֱ׷ӵϢͷ֮󣬲мַ
+bool MyProtoEncode::encode(MyProtoMsg* pMsg, string& out)
+{
+    out.clear();
+    return encodeAppend(pMsg, out);
+}
 
-    // ڴ
-    pData = new uint8_t[len];
+bool MyProtoEncode::encodeAppend(MyProtoMsg* pMsg, string& out)
+{
+    // ԤϢͷλ
+    size_t start = out.size();
+    out.append(MY_PROTO_HEAD_SIZE, '\0');
+
+    // Э壺־λָıֱл׷ӵ
+    switch (pMsg->head.flags & MY_PROTO_CODEC_MASK) {
+    case MY_PROTO_CODEC_MSGPACK:
+        json::to_msgpack(pMsg->body, nlohmann::detail::output_adapter<char>(out));
+        break;
+    case MY_PROTO_CODEC_CBOR:
+        json::to_cbor(pMsg->body, nlohmann::detail::output_adapter<char>(out));
+        break;
+    default: {
+        nlohmann::detail::serializer<json> s(nlohmann::detail::output_adapter<char, string>(out), ' ');
+        s.dump(pMsg->body, false, false, 0);
+        break;
+    }
+    }
+
+    // ÷ѹϢ㹻ʱѹ滻ԭϢ壻ѹûԭ
+    if (pMsg->head.flags & MY_PROTO_FLAG_COMPRESSED) {
+        size_t bodyStart = start + MY_PROTO_HEAD_SIZE;
+        size_t bodyLen = out.size() - bodyStart;
+        size_t threshold = compressionThreshold();
+        bool compressed = false;
+        if (threshold > 0 && bodyLen >= threshold) {
+            compressed = compressBody((const uint8_t*)out.data() + bodyStart, bodyLen, out);
+            if (compressed) {
+                out.erase(bodyStart, bodyLen);
+            }
+        }
+        if (!compressed) {
+            pMsg->head.flags &= ~MY_PROTO_FLAG_COMPRESSED;
+        }
+    }
+
+    size_t frameLen = out.size() - start;
+    if (frameLen > MY_PROTO_MAX_SIZE) {
+        cerr << "Encoded message exceeds maximum size: " << frameLen << endl;
+        out.resize(start);
+        return false;
+    }
+
+    // ϢлԺ³
+    pMsg->head.len = (uint32_t)frameLen;
 
     // Эͷ
+    uint8_t* pData = (uint8_t*)&out[start];
     headEncode(pData, pMsg);
 
-    // Э
-    memcpy(pData + MY_PROTO_HEAD_SIZE, bodyStr.data(), bodyStr.size());
-
     // 㲢CRCֵ
-    uint16_t crc = calculateCRC(pData, len);
+    uint16_t crc = calculateCRC(pData, pMsg->head.len);
     // ֱӽֽCRCֵд뵽CRC_OFFSETλ
     *(uint16_t*)(pData + CRC_OFFSET) = crc;
 
-    return pData;
+    return true;
+}
+
+bool MyProtoEncode::encodeShared(MyProtoMsg* pMsg, MyProtoSharedFrame& frame)
+{
+    shared_ptr<string> data = make_shared<string>();
+    if (!encodeAppend(pMsg, *data)) {
+        return false;
+    }
+
+    size_t bodyLen = data->size() - MY_PROTO_HEAD_SIZE;
+    frame.bodyCRC = updateCRC(0, (const uint8_t*)data->data() + MY_PROTO_HEAD_SIZE, bodyLen);
+    frame.bodyShift = shiftCRC(bodyLen);
+    frame.data = data;
+    return true;
+}
+
+void MyProtoEncode::appendShared(const MyProtoSharedFrame& frame, uint32_t sequence, string& out)
+{
+    size_t start = out.size();
+    out.append(*frame.data);
+    uint8_t* pData = (uint8_t*)&out[start];
+
+    // дкţCRCֶΰ0
+    *(uint32_t*)(pData + SEQUENCE_OFFSET) = htonl(sequence);
+    *(uint16_t*)(pData + CRC_OFFSET) = 0;
+
+    // ֡CRC = ϢͷCRCƽϢ ^ ϢCRC
+    uint16_t headCRC = updateCRC(CRC_INITIAL_VALUE, pData, MY_PROTO_HEAD_SIZE);
+    uint16_t crc = multiplyCRC(headCRC, frame.bodyShift) ^ frame.bodyCRC;
+    *(uint16_t*)(pData + CRC_OFFSET) = crc;
 }
 
 
 //----------------------------------Э----------------------------------
+MyProtoDecode::MyProtoDecode()
+{
+    init();
+}
+
 //ʼЭ״̬
 void MyProtoDecode::init()
 {
     mCurParserStatus = ON_PARSER_INIT;
+    mCurCRC = 0;
+    mCRCBytes = 0;
 }
 
 //սõϢ
@@ -138,58 +231,62 @@ std::shared_ptr<MyProtoMsg> MyProtoDecode::front()
 }
 
 //ֽнЭϢ,lensocketrecv
-// ޸parserеϢ߽紦߼
+//׷ӵλÿ֡ɺֻƶָ룬忪ֽԹϵ
 bool MyProtoDecode::parser(void* data, size_t len) {
+    bool result = true;
     try {
         if (len <= 0)
             return false;
 
-        uint32_t curLen = 0; // ڱδֽ
-        uint32_t parserLen = 0; // vectorѾɵֽ
-        uint8_t* curData = NULL; // ָdata,ǰδֽ
-
-        curData = (uint8_t*)data;
-
-        // ǰҪֽд뵽vector    
-        while (len--) {
-            mCurReserved.push_back(*curData);
-            ++curData;
-        }
-
-        curLen = mCurReserved.size();
-        curData = (uint8_t*)&mCurReserved[0]; // ȡ׵ַ
+        // ǰҪֽд뵽λ
+        mCurReserved.append(data, len);
 
         // ֻҪδֽͳ
-        while (curLen > 0) {
-            bool parserBreak = false;//ڱǽǷҪжϵȴ
-            parserLen = 0; // ѽ
-
+        while (!mCurReserved.empty()) {
             // ͷ
             if (ON_PARSER_INIT == mCurParserStatus) {
-                if (!parserHead(&curData, curLen, parserLen, parserBreak)) {
-                    // ͷʧܣѽ
-                    if (parserLen > 0) {
-                        mCurReserved.erase(mCurReserved.begin(), mCurReserved.begin() + parserLen);
-                    }
-                    return false;
-                }
-                if (parserBreak) {
+                if (mCurReserved.size() < MY_PROTO_HEAD_SIZE) {
                     break; // ˳ѭȴһݵ
                 }
+                const uint8_t* pHead = mCurReserved.peek(MY_PROTO_HEAD_SIZE);
+                if (!parserHead(pHead)) {
+                    // ͷǷʱ޷ȷϢ߽磬ѻ
+                    mCurReserved.clear();
+                    init();
+                    return false;
+                }
+                // CRC֡ʱCRCֶΰ0ֶΣ0ֽڴ
+                static const uint8_t zeroCRC[sizeof(uint16_t)] = { 0, 0 };
+                mCurCRC = updateCRC(CRC_INITIAL_VALUE, pHead, CRC_OFFSET);
+                mCurCRC = updateCRC(mCurCRC, zeroCRC, sizeof(zeroCRC));
+                mCurCRC = updateCRC(mCurCRC, pHead + SEQUENCE_OFFSET, MY_PROTO_HEAD_SIZE - SEQUENCE_OFFSET);
+                mCRCBytes = MY_PROTO_HEAD_SIZE;
+                // ý״̬Ϊͷ
+                mCurParserStatus = ON_PARSER_HEAD;
             }
 
-            // ЭͷʼЭ
+            // ЭͷʼЭ壨ͷڻֱ֡룩
             if (ON_PARSER_HEAD == mCurParserStatus) {
-                if (!parserBody(&curData, curLen, parserLen, parserBreak)) {
-                    // 岿ʧܣѽ
-                    if (parserLen > 0) {
-                        mCurReserved.erase(mCurReserved.begin(), mCurReserved.begin() + parserLen);
-                    }
-                    return false;
+                // ѵĲȼCRCֶ֡εʱ֡ʱCRCҲ
+                size_t available = min((size_t)mCurMsg.head.len, mCurReserved.size());
+                while (mCRCBytes < available) {
+                    size_t segmentLen = available - mCRCBytes;
+                    const uint8_t* pSegment = mCurReserved.segment(mCRCBytes, segmentLen);
+                    mCurCRC = updateCRC(mCurCRC, pSegment, segmentLen);
+                    mCRCBytes += segmentLen;
                 }
-                if (parserBreak) {
+                if (mCurReserved.size() < mCurMsg.head.len) {
                     break;
                 }
+                bool ok = parserBody(mCurReserved.peek(mCurMsg.head.len));
+
+                // ۳ɹƳһ֡֡Ϣ
+                mCurReserved.consume(mCurMsg.head.len);
+                if (!ok) {
+                    init();
+                    result = false;
+                    continue;
+                }
                 // ɹϢ״̬Ϊ
                 mCurParserStatus = ON_PARSER_BODY;
             }
@@ -197,54 +294,35 @@ bool MyProtoDecode::parser(void* data, size_t len) {
             // ɹϢͰϢ
             if (ON_PARSER_BODY == mCurParserStatus) {
                 std::shared_ptr<MyProtoMsg> pMsg = std::make_shared<MyProtoMsg>();
-                *pMsg = mCurMsg;
+                *pMsg = std::move(mCurMsg);
                 mMsgQ.push(pMsg);
 
                 // ý״̬׼һϢ
                 mCurParserStatus = ON_PARSER_INIT;
-
-
-                // ѽܳȲӻƳ
-                uint32_t totalParsed = MY_PROTO_HEAD_SIZE + (mCurMsg.head.len - MY_PROTO_HEAD_SIZE);
-                if (totalParsed <= mCurReserved.size()) {
-                    mCurReserved.erase(mCurReserved.begin(), mCurReserved.begin() + totalParsed);
-                }
-
-                // ʣ
-                curLen = mCurReserved.size();
-                curData = (curLen > 0) ? (uint8_t*)&mCurReserved[0] : NULL;
             }
         }
     }
     catch (const std::exception& e) {
         // ¼쳣ý״ֹ̬
         cerr << "Parser exception: " << e.what() << endl;
+        mCurReserved.clear();
         init(); // ý״̬
         return false;
     }
     catch (...) {
         cerr << "Unknown parser exception" << endl;
+        mCurReserved.clear();
         init();
         return false;
     }
-    return true;
+    return result;
 }
 
 // ڽϢͷ
-bool MyProtoDecode::parserHead(uint8_t** curData, uint32_t& curLen, uint32_t& parserLen, bool& parserBreak) {
-    // 鵱ǰݳǷ㹻ͷ
-    if (curLen < MY_PROTO_HEAD_SIZE) {
-        cout << "[DEBUG] Not enough data for header, need " << MY_PROTO_HEAD_SIZE << ", have " << curLen << endl;
-        parserBreak = true;
-        return true;
-    }
-
-    // ȡǰλ
-    uint8_t* pData = *curData;
-
+bool MyProtoDecode::parserHead(const uint8_t* pData) {
     // ӵ־ӡԭʼֽ
     cout << "[DEBUG] Raw header bytes (first 14 bytes): ";
-    for (uint32_t i = 0; i < MY_PROTO_HEAD_SIZE && i < curLen; i++) {
+    for (uint32_t i = 0; i < MY_PROTO_HEAD_SIZE; i++) {
         printf("%02X ", pData[i]);
     }
     cout << endl;
@@ -253,7 +331,7 @@ bool MyProtoDecode::parserHead(uint8_t** curData, uint32_t& curLen, uint32_t& pa
     mCurMsg.head.version = pData[VERSION_OFFSET];
 
     // ֤汾Ƿ֧
-    if (mCurMsg.head.version != 0 && mCurMsg.head.version != 1) {
+    if (mCurMsg.head.version > MY_PROTO_VERSION_MAX) {
         cerr << "Unsupported protocol version: " << static_cast<int>(mCurMsg.head.version) << endl;
         return false;
     }
@@ -273,8 +351,17 @@ bool MyProtoDecode::parserHead(uint8_t** curData, uint32_t& curLen, uint32_t& pa
     cout << "[DEBUG] Parsed sequence: " << mCurMsg.head.sequence << endl;
 
     // Ϣͣһֽڣ
-    mCurMsg.head.type = pData[TYPE_OFFSET];
-    cout << "[DEBUG] Parsed type: " << static_cast<int>(mCurMsg.head.type) << " (0x" << hex << static_cast<int>(mCurMsg.head.type) << dec << ")" << endl;
+    mCurMsg.head.type = pData[TYPE_OFFSET] & MY_PROTO_TYPE_MASK;
+    mCurMsg.head.flags = pData[TYPE_OFFSET] & MY_PROTO_FLAG_MASK;
+    cout << "[DEBUG] Parsed type: " << static_cast<int>(mCurMsg.head.type) << " (0x" << hex << static_cast<int>(mCurMsg.head.type) 
+        << "), flags: 0x" << static_cast<int>(mCurMsg.head.flags) << dec << endl;
+
+    // ʶϢ޷
+    uint8_t codec = mCurMsg.head.flags & MY_PROTO_CODEC_MASK;
+    if (codec != MY_PROTO_CODEC_JSON && codec != MY_PROTO_CODEC_MSGPACK && codec != MY_PROTO_CODEC_CBOR) {
+        cerr << "Unsupported body codec: 0x" << hex << static_cast<int>(codec) << dec << endl;
+        return false;
+    }
 
     // ϲϢ֤߼ֵ
     if (mCurMsg.head.type != 0 && mCurMsg.head.type != 1) {
@@ -294,89 +381,72 @@ bool MyProtoDecode::parserHead(uint8_t** curData, uint32_t& curLen, uint32_t& pa
         return false;
     }
 
-    // ½ָλãƶͷ֮һλ
-    *curData = pData + MY_PROTO_HEAD_SIZE;
-    curLen -= MY_PROTO_HEAD_SIZE;
-    parserLen += MY_PROTO_HEAD_SIZE;
-
-    // ý״̬Ϊͷ
-    mCurParserStatus = ON_PARSER_HEAD;
-
     return true;
 }
 
 // ڽϢ
-bool MyProtoDecode::parserBody(uint8_t** curData, uint32_t& curLen, uint32_t& parserLen, bool& parserBreak) {
+bool MyProtoDecode::parserBody(const uint8_t* pFrame) {
     // ȡϢ峤
     uint32_t bodyLen = mCurMsg.head.len - MY_PROTO_HEAD_SIZE;
+    mCurMsg.rawBody.clear();
+    mCurMsg.error.clear();
+
+    // УCRC𻵵֡ؽJSONCRCݵʱѾ
+    if (mCurCRC != mCurMsg.head.crc) {
+        cerr << "CRC check failed! Expected: " << mCurCRC
+            << " (0x" << hex << mCurCRC << dec << ")"
+            << ", Received: " << mCurMsg.head.crc
+            << " (0x" << hex << mCurMsg.head.crc << dec << ")" << endl;
+
+        // ӵϢӡϢͷǰֽ
+        cerr << "[DEBUG] First 16 bytes of message: ";
+        for (int i = 0; i < min(16, (int)mCurMsg.head.len); i++) {
+            cerr << hex << setw(2) << setfill('0') << (int)pFrame[i] << " ";
+        }
+        cerr << dec << endl;
 
-    // 鵱ǰݳǷ㹻Ϣ
-    if (curLen < bodyLen) {
-        parserBreak = true;
-        return true;
+        return false;
     }
+    cout << "[DEBUG] CRC check passed. Calculated: " << mCurCRC << ", Original: " << mCurMsg.head.crc << endl;
 
     try {
-        // ϢݽΪJSON
-        string bodyStr((char*)*curData, bodyLen);
+        // ־λָıϢ壬ֱӴӻٿַ
+        const uint8_t* pBody = pFrame + MY_PROTO_HEAD_SIZE;
 
-        // ֤bodyStrǷΪ
-        if (bodyStr.empty()) {
-            mCurMsg.body = json::object(); // JSON
-        }
-        else {
-            mCurMsg.body = json::parse(bodyStr);
+        // ѹϢȽѹ
+        string decompressed;
+        if (mCurMsg.head.flags & MY_PROTO_FLAG_COMPRESSED) {
+            if (!decompressBody(pBody, bodyLen, MY_PROTO_MAX_SIZE, decompressed)) {
+                return false;
+            }
+            pBody = (const uint8_t*)decompressed.data();
+            bodyLen = (uint32_t)decompressed.size();
         }
 
-        // ֤JSON
-        if (!validateJsonContent(mCurMsg.body)) {
-            cerr << "Invalid JSON content in message body" << endl;
-            return false;
+        // ҵķֻԭʼֽڣУҵͻһSAXɨ
+        if (mCurMsg.head.type == MY_PROTO_TYPE_DATA && isRawBodyService(mCurMsg.head.server)) {
+            if (mCurMsg.head.flags & MY_PROTO_FLAG_COMPRESSED) {
+                mCurMsg.rawBody = std::move(decompressed);
+            }
+            else {
+                mCurMsg.rawBody.assign((const char*)pBody, bodyLen);
+            }
+            return true;
         }
 
-        // CRCУʵ
-       // 1. ȡԭʼϢʼλ
-        // ӱʼǰݵƫ
-        uint32_t offsetToCurrentData = mCurReserved.size() - curLen;
-        uint8_t* originalMsgStart = (uint8_t*)&mCurReserved[0] + offsetToCurrentData - MY_PROTO_HEAD_SIZE;
-        uint32_t totalMsgLen = MY_PROTO_HEAD_SIZE + bodyLen;
-        // 2. ԭʼCRCֵ
-        uint16_t originalCRC = *(uint16_t*)(originalMsgStart + CRC_OFFSET);
-        // 3. һʱCRCֶ0
-        vector<uint8_t> tempMsgData(originalMsgStart, originalMsgStart + totalMsgLen);
-        memset(&tempMsgData[CRC_OFFSET], 0, sizeof(uint16_t)); // CRCֶ0
-
-        // 4. CRC
-        uint16_t calculatedCRC = calculateCRC(tempMsgData.data(), totalMsgLen);
-
-        // 5. ֤CRC
-        if (calculatedCRC != originalCRC) {
-            cerr << "CRC check failed! Expected: " << calculatedCRC
-                << " (0x" << hex << calculatedCRC << dec << ")"
-                << ", Received: " << originalCRC
-                << " (0x" << hex << originalCRC << dec << ")" << endl;
-
-            // ӵϢӡϢͷǰֽ
-            cerr << "[DEBUG] First 16 bytes of message: ";
-            for (int i = 0; i < min(16, (int)totalMsgLen); i++) {
-                cerr << hex << setw(2) << setfill('0') << (int)originalMsgStart[i] << " ";
+        // ͬһSAXɽУ飺ϢעģʽУ飬Ϣֻͨù
+        const RequestSchema* schema = mCurMsg.head.type == MY_PROTO_TYPE_DATA ? findRequestSchema(mCurMsg.head.server) : nullptr;
+        string error;
+        if (!validateRequestBody(pBody, bodyLen, mCurMsg.head.flags, schema, &mCurMsg.body, error)) {
+            cerr << "Invalid message body for server " << mCurMsg.head.server << ": " << error << endl;
+            if (mCurMsg.head.type != MY_PROTO_TYPE_DATA) {
+                return false;
             }
-            cerr << dec << endl;
-
-            return false;
+            // ϢȻϲ㣬ԭӴкŻظ󣬿ͻ˲صȵʱ
+            mCurMsg.body = json();
+            mCurMsg.error = std::move(error);
+            return true;
         }
-        cout << "[DEBUG] CRC check passed. Calculated: " << calculatedCRC << ", Original: " << originalCRC << endl;
-        // Ϣtype=0ý״̬Ϊ
-        if (mCurMsg.head.type == 0) {
-            mCurParserStatus = ON_PARSER_BODY;
-        }
-
-        // ½ָλãƶϢ֮һλ
-        (*curData) += bodyLen;
-        // ʣݳ
-        curLen -= bodyLen;
-        // ѽݳ
-        parserLen += bodyLen;
 
         // ؽɹ
         return true;
@@ -389,47 +459,4 @@ bool MyProtoDecode::parserBody(uint8_t** curData, uint32_t& curLen, uint32_t& pa
         cerr << "Message body parse exception: " << e.what() << endl;
         return false;
     }
-}
-
-// 滻ṹΪͳĵʽ
-bool validateJsonContent(const json& j) {
-    // ֤ȷJSONǿյ
-    if (j.empty()) {
-        cerr << "Empty JSON content" << endl;
-        return false;
-    }
-
-    // ҵӾ֤
-    // ֻʾԸʵЭҪչ
-
-    // 1. ϢΪϢʱǷҪֶ
-    // ע⣺ҪMyProtoMsgṹtypeֶΣǰ޷ֱӷ
-    // Ҫ޸ĺ߽˺ΪԱ
-
-    // 2. ֤JSONеֵΧַȵ
-    try {
-        // JSON󣬼ǷǷֵ
-        for (auto it = j.begin(); it != j.end(); ++it) {
-            const string& key = it.key();
-            const json& value = it.value();
-
-            // ǷϷ粻ַ
-            if (key.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_") != string::npos) {
-                cerr << "Invalid character in JSON key: " << key << endl;
-                return false;
-            }
-
-            // ֵַǷ񳬹
-            if (value.is_string() && value.get<string>().length() > 1024) { // 1024󳤶
-                cerr << "String value too long for key: " << key << endl;
-                return false;
-            }
-        }
-    }
-    catch (const std::exception& e) {
-        cerr << "JSON validation error: " << e.what() << endl;
-        return false;
-    }
-
-    return true;
 }
\ No newline at end of file
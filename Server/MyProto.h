@@ -5,7 +5,10 @@
 #include <vector>
 #include <iostream>
 #include <cstring>
+#include <memory>
 #include "json.hpp"
+#include "ring_buffer.h"
+#include "crc16.h"
 #ifdef _WIN32
 #include <WinSock2.h>
 #pragma comment(lib, "ws2_32.lib")
@@ -16,6 +19,9 @@ using namespace std;
 using json = nlohmann::json;
 const uint32_t MY_PROTO_MAX_SIZE = 1024 * 1024*10;//10MЭ
 const uint32_t MY_PROTO_HEAD_SIZE = 14;//ЭͷС
+// Э汾1ǰҵJSONַbody["data"]У2body["data"]ֱǶ׶
+const uint8_t MY_PROTO_VERSION_NESTED_DATA = 2;
+const uint8_t MY_PROTO_VERSION_MAX = 2;
 extern const uint16_t CRC_INITIAL_VALUE;
 extern const uint16_t CRC_POLYNOMIAL;    // CRCʽ
 // Эͷֶƫ
@@ -38,6 +44,27 @@ typedef enum MyProtoMsgType
 	MY_PROTO_TYPE_HEARTBEAT = 2,   // Ϣ
 	MY_PROTO_TYPE_HEARTBEAT_ACK = 3 // ӦϢ
 }MyProtoMsgType;
+// Ϣֽڣ4λΪϢͣ4λΪ־λ
+const uint8_t MY_PROTO_TYPE_MASK = 0x0F;
+const uint8_t MY_PROTO_FLAG_MASK = 0xF0;
+// Ϣ뷽ʽ־λĵ2λ־ϿͻʹJSONı
+typedef enum MyProtoCodec
+{
+	MY_PROTO_CODEC_JSON = 0x00,    // JSONı
+	MY_PROTO_CODEC_MSGPACK = 0x10, // MessagePack
+	MY_PROTO_CODEC_CBOR = 0x20,    // CBOR
+	MY_PROTO_CODEC_MASK = 0x30
+}MyProtoCodec;
+const int MY_PROTO_CODEC_COUNT = 3; //뷽ʽ(codec >> 4)Ϊ±
+// Ϣ徭zstdѹʱɵ÷λʾѹϢﵽֵѹСŻᱣ
+const uint8_t MY_PROTO_FLAG_COMPRESSED = 0x40;
+// ͷܹѹѹϢ壬ֻԴ˱־Ŀͻѹ
+const uint8_t MY_PROTO_FLAG_ACCEPT_COMPRESSED = 0x80;
+// кԼͻкλΪ0ÿϵ31λƣ
+// طԭкţܸͬԿܱطкţӦкš
+// ݴ˶дȥأк65536ϵļ¼ڣ
+// кŴΪͻ˼ã֮ǰļ¼ϡ
+// ͵ϢʹλΪ1кţreliable_msg_manager.h
 #pragma pack(push, 1)
 struct MyProtoHead
 {
@@ -47,16 +74,31 @@ struct MyProtoHead
 	uint16_t crc; //CRCУֵ
 	uint32_t sequence; //Эк
 	uint8_t type; //Э 0- 1-ȷϢ 2- 3-Ӧ
+	uint8_t flags = 0; //־λtypeһֽڣ4λϢ뷽ʽ
 };
 #pragma pack(pop)
 struct MyProtoMsg
 {
 	MyProtoHead head;
 	json body;
+	string rawBody; //עΪԭʼϢķ񲻹bodyѹԭʼֽڣҵֱӽ
+	string error; //ϢϢδͨУʱΪԭbodyΪգӴֱӻظӦ
+	bool deferred = false; //ʱӦδȡʽӦӴӦȴӳӦ
+};
+// ԤĹ֡ϢֻлһΣӹͬһֽڣ
+// ͸ÿʱֻдϢͷекźCRC
+struct MyProtoSharedFrame
+{
+	shared_ptr<const string> data; //һ֡кźCRCֶڷʱд
+	uint16_t bodyCRC;   //Ϣ岿0ΪֵCRC
+	uint16_t bodyShift; //x^(8*Ϣ峤) mod ʽڰϢͷCRCƽϢ
 };
-// CRC㺯
+// CRC㺯ֶμʹcrc16.hеupdateCRC
 uint16_t calculateCRC(const uint8_t* data, size_t length);
-bool validateJsonContent(const json& j);
+// עϢҵֱӽķţSAXΪͻ󣩣ҲУ飬
+// ҵʱģʽУ顣ڿʼϢǰ
+void registerRawBodyService(uint16_t server);
+bool isRawBodyService(uint16_t server);
 //
 //ӡЭϢ
 void printMyProtoMsg(MyProtoMsg& msg);
@@ -65,7 +107,17 @@ class MyProtoEncode
 {
 public:
 	//ЭϢװpMsgֻвݣJsonЭ壬ţǶϢ޸ĳϢʱҪ±Э
-	uint8_t* encode(MyProtoMsg* pMsg, uint32_t& len); //سϢںsocket
+	uint8_t* encode(MyProtoMsg* pMsg, uint32_t& len); //سϢںsocketݣ÷delete[]
+	//뵽÷ṩĻԤϢͷλãϢֱлֻ֡дһڴ棻
+	//outᱻպãͷţʺÿ¼ѭһʹ
+	bool encode(MyProtoMsg* pMsg, string& out);
+	//׷ӱ뵽outĩβڰѶ֡ϲͬһһд
+	//head.flagsMY_PROTO_FLAG_COMPRESSEDʱϢﵽѹֵѹñ־
+	bool encodeAppend(MyProtoMsg* pMsg, string& out);
+	//Ϊ֡㲥ʱֻлһ
+	bool encodeShared(MyProtoMsg* pMsg, MyProtoSharedFrame& frame);
+	//ѹָ֡к׷ӵoutĩβֻ¼ϢͷֵCRC
+	void appendShared(const MyProtoSharedFrame& frame, uint32_t sequence, string& out);
 private:
 	//Эͷװ
 	void headEncode(uint8_t* pData, MyProtoMsg* pMsg);
@@ -75,9 +127,12 @@ class MyProtoDecode
 private:
 	MyProtoMsg mCurMsg;
 	queue<shared_ptr<MyProtoMsg>> mMsgQ;//õЭϢ
-	vector<uint8_t> mCurReserved; //δֽԻûнݣֽڣ
+	RingBuffer mCurReserved; //δֽԻûнݣֽڣ
 	MyProtoParserStatus mCurParserStatus; //ǰܷ״̬
+	uint16_t mCurCRC; //ǰ֡ѵﲿֵCRCCRCֶΰ0㣩
+	size_t mCRCBytes; //ǰ֡ѼCRCֽ
 public:
+	MyProtoDecode();
 	void init();
 	void clear();//սõϢ
 	bool empty();//жϽõϢǷΪ
@@ -85,8 +140,7 @@ public:
 	shared_ptr<MyProtoMsg> front();//ȡһõϢ
 	bool parser(void *data,size_t len);//ֽнЭϢlenеֽȣͨsocketԻȡ
 private:
-	bool parserHead(uint8_t** curData,uint32_t& curLen, uint32_t& parserLen, bool& parserBreak);
-	bool parserBody(uint8_t** curData, uint32_t& curLen,
-		uint32_t& parserLen, bool& parserBreak); //ڽϢ
+	bool parserHead(const uint8_t* pData); //ڽϢͷpDataٰMY_PROTO_HEAD_SIZEֽ
+	bool parserBody(const uint8_t* pFrame); //ڽϢ壬pFrameָϢͷڵһ֡
 };
 
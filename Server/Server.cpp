@@ -2,17 +2,21 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <algorithm>
 #include "DatabaseManager.h"
+#include "body_compression.h"
 
-Server::Server() : connection_handler_(nullptr), reliable_msg_manager_(nullptr), is_running_(false), server_port_(0) {
+Server::Server() : connection_handler_(nullptr), is_running_(false), server_port_(0),
+    event_loop_num_(std::max(1u, std::thread::hardware_concurrency())), worker_thread_num_(8),
+    compression_threshold_(4096) {
 }
 
 Server::~Server() {
     stop();
-    if (reliable_msg_manager_) {
-        delete reliable_msg_manager_;
-        reliable_msg_manager_ = nullptr;
+    for (ReliableMsgManager* manager : reliable_msg_managers_) {
+        delete manager;
     }
+    reliable_msg_managers_.clear();
 }
 
 // 在initialize方法中添加初始化代码
@@ -28,8 +32,13 @@ bool Server::initialize(const std::string& db_host, const std::string& db_user,
     enhanced_business_handler_ = EnhancedBusinessHandler::getInstance();
     enhanced_business_handler_->initialize(&business_handler_);
 
-    // 创建可靠消息管理器
-    reliable_msg_manager_ = new ReliableMsgManager(3, 2000); // 最大3次重传，2秒间隔
+    // 创建可靠消息管理器，每个事件循环独立一份
+    for (int i = 0; i < event_loop_num_; ++i) {
+        ReliableMsgManager* manager = new ReliableMsgManager(3, 1000); // 最大3次重传，没有RTT样本时超时1秒
+        manager->setRtoConfig(200, 60000); // 按RTT估计的重传超时限制在200毫秒到60秒之间，重传时指数退避
+        manager->setWindowConfig(64, 1024 * 1024, 256, 4 * 1024 * 1024); // 每个连接最多64条/1MB在途，另可排队256条/4MB
+        reliable_msg_managers_.push_back(manager);
+    }
 
     // 获取连接处理器实例
     connection_handler_ = ConnectionHandler::getInstance();
@@ -54,13 +63,28 @@ bool Server::start(int port) {
     }
 
     // 初始化连接处理器
-    if (!connection_handler_->initialize(enhanced_business_handler_->getBusinessHandler(), reliable_msg_manager_)) {
+    if (!connection_handler_->initialize(enhanced_business_handler_->getBusinessHandler(), reliable_msg_managers_)) {
         std::cerr << "连接处理器初始化失败" << std::endl;
         return false;
     }
 
     // 设置心跳配置
     connection_handler_->setHeartbeatConfig(3000, 60000); // 3秒心跳，60秒超时
+    connection_handler_->setAckDelay(5); // 5毫秒内响应未就绪才单独发确认帧
+    connection_handler_->setDedupWindow(64, 256 * 1024); // 每个连接记住最近64个写请求，响应最多保存256KB
+
+    // 消息体压缩：字典加载失败时退回到不带字典的压缩
+    setCompressionConfig(compression_threshold_, 3);
+    if (!compression_dict_path_.empty() && !loadCompressionDictionary(compression_dict_path_)) {
+        std::cerr << "压缩字典加载失败，使用无字典压缩：" << compression_dict_path_ << std::endl;
+    }
+
+    // 启动业务工作线程池，业务处理不再占用事件循环线程
+    worker_pool_.start(worker_thread_num_);
+    connection_handler_->setWorkerPool(&worker_pool_);
+    business_handler_.setTaskExecutor([this](std::function<void()> task) {
+        return worker_pool_.submit(std::move(task));
+    });
 
     // 启动服务器
     if (!connection_handler_->startServer(port)) {
@@ -83,10 +107,13 @@ void Server::stop() {
     std::cout << "服务器正在停止..." << std::endl;
 
     // 停止超时检测
-    if (reliable_msg_manager_) {
-        reliable_msg_manager_->stopTimeoutCheck();
+    for (ReliableMsgManager* manager : reliable_msg_managers_) {
+        manager->stopTimeoutCheck();
     }
 
+    // 先等待工作线程处理完已提交的请求，再关闭事件循环
+    worker_pool_.stop();
+
     // 停止服务器
     connection_handler_->stopServer();
 
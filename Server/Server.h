@@ -1,18 +1,25 @@
 #pragma once
 #include <string>
+#include <vector>
 #include "business_handler.h"
 #include "connection_handler.h"
 #include "reliable_msg_manager.h"
 #include "EnhancedBussinessHandler.h"
+#include "worker_pool.h"
 // 服务器类，封装所有服务器功能
 class Server {
 private:
 EnhancedBusinessHandler* enhanced_business_handler_; // 添加EnhancedBussinessHandler指针
     BusinessHandler business_handler_;          // 业务处理器
     ConnectionHandler* connection_handler_;     // 连接处理器
-    ReliableMsgManager* reliable_msg_manager_;  // 可靠消息管理器
+    std::vector<ReliableMsgManager*> reliable_msg_managers_; // 可靠消息管理器，每个事件循环一个
     bool is_running_;                           // 服务器运行状态
     int server_port_;                           // 服务器端口
+    int event_loop_num_;                        // 事件循环（IO线程）数量
+    WorkerPool worker_pool_;                    // 业务工作线程池
+    int worker_thread_num_;                     // 业务工作线程数量
+    size_t compression_threshold_;              // 消息体压缩阈值（字节），0表示不压缩
+    std::string compression_dict_path_;         // zstd压缩字典路径，为空则不使用字典
 
 public:
     // 构造函数和析构函数
@@ -37,6 +44,18 @@ public:
     // 获取服务器端口
     int getPort() const { return server_port_; }
 
+    // 设置事件循环数量，需在initialize之前调用
+    void setEventLoopNum(int num) { event_loop_num_ = num > 0 ? num : 1; }
+
+    // 设置业务工作线程数量，需在start之前调用
+    void setWorkerThreadNum(int num) { worker_thread_num_ = num > 0 ? num : 1; }
+
+    // 设置消息体压缩阈值和字典，需在start之前调用；只对声明能解压的客户端生效
+    void setCompression(size_t threshold, const std::string& dict_path = "") {
+        compression_threshold_ = threshold;
+        compression_dict_path_ = dict_path;
+    }
+
 private:
     // 初始化数据库连接
     bool initializeDatabase(const std::string& host, const std::string& user,
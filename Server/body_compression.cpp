@@ -0,0 +1,105 @@
+#include "body_compression.h"
+#include <zstd.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+namespace {
+
+size_t g_threshold = 4096;
+int g_level = 3;
+ZSTD_CDict* g_cdict = nullptr; // 只读，可在多个线程间共享
+ZSTD_DDict* g_ddict = nullptr;
+
+// 每个线程一份压缩/解压上下文，反复使用避免每帧重新分配
+struct ThreadContext {
+    ZSTD_CCtx* cctx;
+    ZSTD_DCtx* dctx;
+    std::string scratch;
+
+    ThreadContext() : cctx(ZSTD_createCCtx()), dctx(ZSTD_createDCtx()) {}
+    ~ThreadContext() {
+        ZSTD_freeCCtx(cctx);
+        ZSTD_freeDCtx(dctx);
+    }
+};
+
+thread_local ThreadContext t_context;
+
+} // namespace
+
+void setCompressionConfig(size_t threshold, int level) {
+    g_threshold = threshold;
+    g_level = level;
+}
+
+size_t compressionThreshold() {
+    return g_threshold;
+}
+
+bool loadCompressionDictionary(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open compression dictionary: " << path << std::endl;
+        return false;
+    }
+    std::vector<char> dict((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    ZSTD_CDict* cdict = ZSTD_createCDict(dict.data(), dict.size(), g_level);
+    ZSTD_DDict* ddict = ZSTD_createDDict(dict.data(), dict.size());
+    if (!cdict || !ddict) {
+        std::cerr << "Invalid compression dictionary: " << path << std::endl;
+        ZSTD_freeCDict(cdict);
+        ZSTD_freeDDict(ddict);
+        return false;
+    }
+
+    ZSTD_freeCDict(g_cdict);
+    ZSTD_freeDDict(g_ddict);
+    g_cdict = cdict;
+    g_ddict = ddict;
+    std::cout << "Compression dictionary loaded: " << path << ", size: " << dict.size()
+              << ", id: " << ZSTD_getDictID_fromDDict(ddict) << std::endl;
+    return true;
+}
+
+bool compressBody(const uint8_t* src, size_t len, std::string& out) {
+    ThreadContext& ctx = t_context;
+    ctx.scratch.resize(ZSTD_compressBound(len));
+
+    size_t result = g_cdict
+        ? ZSTD_compress_usingCDict(ctx.cctx, &ctx.scratch[0], ctx.scratch.size(), src, len, g_cdict)
+        : ZSTD_compressCCtx(ctx.cctx, &ctx.scratch[0], ctx.scratch.size(), src, len, g_level);
+    if (ZSTD_isError(result)) {
+        std::cerr << "Body compression failed: " << ZSTD_getErrorName(result) << std::endl;
+        return false;
+    }
+    if (result >= len) {
+        return false;
+    }
+    out.append(ctx.scratch.data(), result);
+    return true;
+}
+
+bool decompressBody(const uint8_t* src, size_t len, size_t max_len, std::string& out) {
+    // 压缩时总会写入原始长度，据此一次分配到位，也能拒绝解压后过大的帧
+    unsigned long long content_size = ZSTD_getFrameContentSize(src, len);
+    if (content_size == ZSTD_CONTENTSIZE_ERROR || content_size == ZSTD_CONTENTSIZE_UNKNOWN ||
+        content_size > max_len) {
+        std::cerr << "Invalid compressed body, content size: " << content_size << std::endl;
+        return false;
+    }
+
+    ThreadContext& ctx = t_context;
+    out.resize((size_t)content_size);
+    size_t result = g_ddict
+        ? ZSTD_decompress_usingDDict(ctx.dctx, &out[0], out.size(), src, len, g_ddict)
+        : ZSTD_decompressDCtx(ctx.dctx, &out[0], out.size(), src, len);
+    if (ZSTD_isError(result) || result != content_size) {
+        std::cerr << "Body decompression failed: "
+                  << (ZSTD_isError(result) ? ZSTD_getErrorName(result) : "size mismatch") << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,26 @@
+#ifndef __BODY_COMPRESSION_H__
+#define __BODY_COMPRESSION_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+// 消息体zstd压缩。配置和字典为进程内全局设置，需在服务器启动前完成；
+// 压缩/解压上下文每个线程一份，事件循环线程和工作线程可以同时使用
+
+// 设置压缩阈值（字节，消息体不小于该值才压缩，0表示不压缩）和压缩级别
+void setCompressionConfig(size_t threshold, int level);
+
+// 压缩阈值，0表示不压缩
+size_t compressionThreshold();
+
+// 加载离线训练好的字典（zstd --train生成），客户端需使用同一份字典
+bool loadCompressionDictionary(const std::string& path);
+
+// 压缩src并追加到out，压缩失败或压缩后没有变小时返回false且out不变
+bool compressBody(const uint8_t* src, size_t len, std::string& out);
+
+// 解压src到out（覆盖），解压后超过max_len的帧视为非法
+bool decompressBody(const uint8_t* src, size_t len, size_t max_len, std::string& out);
+
+#endif // __BODY_COMPRESSION_H__
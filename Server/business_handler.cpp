@@ -25,7 +25,13 @@ void BusinessHandler::logMessage(int conn_id, const MyProtoMsg& msg) {
     // 获取当前时间
     auto now = std::chrono::system_clock::now();
     auto now_c = std::chrono::system_clock::to_time_t(now);
-    std::tm local_tm = *std::localtime(&now_c);
+    // 业务处理会在多个工作线程并发执行，使用线程安全的版本
+    std::tm local_tm;
+#ifdef _WIN32
+    localtime_s(&local_tm, &now_c);
+#else
+    localtime_r(&now_c, &local_tm);
+#endif
     
     // 输出时间戳和连接信息
     std::cout << "[" << std::put_time(&local_tm, "%Y-%m-%d %H:%M:%S") << "] " 
@@ -71,12 +77,16 @@ void BusinessHandler::logMessage(int conn_id, const MyProtoMsg& msg) {
     std::cout << "}" << std::endl;
 }
 bool BusinessHandler::handleMessage(int conn_id, MyProtoMsg& msg) {
+    MyProtoMsg response;
+    return handleMessage(conn_id, msg, response);
+}
+
+bool BusinessHandler::handleMessage(int conn_id, MyProtoMsg& msg, MyProtoMsg& response) {
   // 在控制台输出接收到的消息
   logMessage(conn_id, msg);  
   auto it = handlers_.find(msg.head.server);
     if (it != handlers_.end()) {
-        // 创建响应消息
-        MyProtoMsg response;
+        // 填充响应消息头
         response.head.version = msg.head.version;
         response.head.server = msg.head.server;
         response.head.sequence = msg.head.sequence; // 使用相同的序列号
@@ -88,18 +98,55 @@ bool BusinessHandler::handleMessage(int conn_id, MyProtoMsg& msg) {
             return true;
         } catch (const std::exception& e) {
             std::cerr << "Exception in message handler: " << e.what() << std::endl;
+            response.body = json::object();
+            response.body["success"] = false;
+            response.body["message"] = std::string("Exception in message handler: ") + e.what();
             return false;
         }
     } else {
         std::cerr << "No handler for server_id: " << msg.head.server << std::endl;
+        // 同样回复错误响应，客户端不必等到超时
+        response.head.version = msg.head.version;
+        response.head.server = msg.head.server;
+        response.head.sequence = msg.head.sequence;
+        response.head.type = 0;
+        response.body = json::object();
+        response.body["success"] = false;
+        response.body["message"] = "No handler for server_id: " + std::to_string(msg.head.server);
+        return false;
+    }
+}
+
+bool BusinessHandler::sendChunk(int conn_id, MyProtoMsg& chunk, ChunkSentCallback on_sent) {
+    if (!chunk_sender_) {
+        std::cerr << "No chunk sender, drop stream chunk for conn_id: " << conn_id 
+                  << ", server_id: " << chunk.head.server << std::endl;
+        return false;
+    }
+    return chunk_sender_(conn_id, chunk, false, on_sent);
+}
+
+bool BusinessHandler::sendDeferredResponse(int conn_id, MyProtoMsg& response) {
+    if (!chunk_sender_) {
+        std::cerr << "No chunk sender, drop deferred response for conn_id: " << conn_id 
+                  << ", server_id: " << response.head.server << std::endl;
         return false;
     }
+    return chunk_sender_(conn_id, response, true, ChunkSentCallback());
+}
+
+bool BusinessHandler::submitTask(std::function<void()> task) {
+    if (!task_executor_) {
+        return false;
+    }
+    return task_executor_(std::move(task));
 }
 
 bool BusinessHandler::sendResponse(int conn_id, MyProtoMsg& response) {
-    // 这个方法需要与ConnectionHandler集成
-    // 实际的发送逻辑由ConnectionHandler实现
-    std::cout << "Response prepared for conn_id: " << conn_id 
-              << ", server_id: " << response.head.server << std::endl;
-    return true;
+    if (!response_sender_) {
+        std::cerr << "No response sender, drop response for conn_id: " << conn_id 
+                  << ", server_id: " << response.head.server << std::endl;
+        return false;
+    }
+    return response_sender_(conn_id, response);
 }
\ No newline at end of file
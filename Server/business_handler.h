@@ -11,11 +11,27 @@
 // 消息处理函数类型定义
 typedef std::function<void(int conn_id, MyProtoMsg& msg, MyProtoMsg& response)> MessageHandler;
 
+// 响应发送函数类型定义（由ConnectionHandler提供）
+typedef std::function<bool(int conn_id, MyProtoMsg& response)> ResponseSender;
+
+// 流式响应分片写出后的回调，连接已断开时参数为false
+typedef std::function<void(bool ok)> ChunkSentCallback;
+
+// 流式响应分片发送函数类型定义（由ConnectionHandler提供），分片内容会被移走；
+// last为true时该帧是处理函数返回时标记为延迟的最终响应，不回调on_sent
+typedef std::function<bool(int conn_id, MyProtoMsg& chunk, bool last, ChunkSentCallback on_sent)> ChunkSender;
+
+// 后台任务提交函数类型定义（由Server提供业务工作线程池），提交失败返回false
+typedef std::function<bool(std::function<void()> task)> TaskExecutor;
+
 // 业务处理器类
 class BusinessHandler {
 private:
     // 服务号到处理函数的映射
     std::unordered_map<uint16_t, MessageHandler> handlers_;
+    ResponseSender response_sender_; // 响应发送函数
+    ChunkSender chunk_sender_;       // 流式响应分片发送函数
+    TaskExecutor task_executor_;     // 后台任务提交函数
     void logMessage(int conn_id, const MyProtoMsg& msg);
 public:
     BusinessHandler();
@@ -30,9 +46,32 @@ public:
     // 处理消息
     bool handleMessage(int conn_id, MyProtoMsg& msg);
     
-    // 发送响应（通常由ConnectionHandler调用）
+    // 处理消息并返回处理函数生成的响应（可在工作线程调用），
+    // 响应的序列号与请求相同；找不到处理函数或处理出错时响应中带有错误信息
+    bool handleMessage(int conn_id, MyProtoMsg& msg, MyProtoMsg& response);
+    
+    // 设置响应发送函数
+    void setResponseSender(ResponseSender sender) { response_sender_ = sender; }
+    
+    // 主动发送响应，用于处理函数返回之后才产生的结果（可在任意线程调用）
     bool sendResponse(int conn_id, MyProtoMsg& response);
     
+    // 设置流式响应分片发送函数
+    void setChunkSender(ChunkSender sender) { chunk_sender_ = sender; }
+    
+    // 发送流式响应的一个分片（可在任意线程调用），分片写入连接后回调on_sent
+    bool sendChunk(int conn_id, MyProtoMsg& chunk, ChunkSentCallback on_sent);
+    
+    // 发送处理函数返回时标记为延迟（response.deferred）的最终响应（可在任意线程调用），
+    // 与分片一样按请求顺序写出，在该请求的所有分片之后
+    bool sendDeferredResponse(int conn_id, MyProtoMsg& response);
+    
+    // 设置后台任务提交函数
+    void setTaskExecutor(TaskExecutor executor) { task_executor_ = executor; }
+    
+    // 把任务提交到业务工作线程池（如批量请求中可并行的子请求），没有线程池或提交失败时返回false
+    bool submitTask(std::function<void()> task);
+    
 };
 
 #endif // __BUSINESS_HANDLER_H__
\ No newline at end of file
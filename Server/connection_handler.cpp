@@ -1,75 +1,165 @@
 #include "connection_handler.h"
 #include "business_handler.h"
 #include "reliable_msg_manager.h"
+#include "worker_pool.h"
 
 #include <fstream>
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 
 ConnectionHandler* ConnectionHandler::instance_ = nullptr;
+
+// 输出缓冲区累计超过该大小时立即写出，不再等待合并
+static const size_t MAX_COALESCE_BYTES = 256 * 1024;
+// 写出后缓冲区容量超过该值则释放，避免偶发的大帧让缓冲区长期占用内存
+static const size_t MAX_IDLE_BUFFER_CAPACITY = 64 * 1024;
+// 去重记录落后连接上最大请求序列号超过该值即过期；请求序列号比最大值小超过该值视为客户端计数器重置
+static const uint32_t DEDUP_SEQUENCE_SPAN = 65536;
+
+// 一次广播的编码结果，各事件循环共享。下标为(codec >> 4)，压缩的再加MY_PROTO_CODEC_COUNT
+struct BroadcastFrames {
+    static const int VARIANTS = MY_PROTO_CODEC_COUNT * 2;
+
+    MyProtoMsg msg;              // 调用方消息的副本，编码时改写它的标志位
+    std::mutex mutex;
+    bool encoded[VARIANTS] = {}; // 已编码过（失败的也算，不再重试）
+    MyProtoSharedFrame frames[VARIANTS];
+
+    // 取出一种编码方式的帧，第一次需要时才序列化，编码失败返回nullptr
+    const MyProtoSharedFrame* frame(int variant, MyProtoEncode& encoder) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!encoded[variant]) {
+            encoded[variant] = true;
+            msg.head.flags = (msg.head.flags & ~(MY_PROTO_CODEC_MASK | MY_PROTO_FLAG_COMPRESSED)) |
+                             (uint8_t)((variant % MY_PROTO_CODEC_COUNT) << 4) |
+                             (variant >= MY_PROTO_CODEC_COUNT ? MY_PROTO_FLAG_COMPRESSED : 0);
+            if (!encoder.encodeShared(&msg, frames[variant])) {
+                std::cerr << "Failed to encode broadcast message, codec: "
+                          << (int)(msg.head.flags & MY_PROTO_CODEC_MASK) << std::endl;
+            }
+        }
+        return frames[variant].data ? &frames[variant] : nullptr;
+    }
+};
 ConnectionHandler::ConnectionHandler() : loop_(nullptr), server_(nullptr), 
-    business_handler_(nullptr), reliable_msg_manager_(nullptr) {
-    // 初始化协议解码器
-    proto_decoder_.init();
+    business_handler_(nullptr), worker_pool_(nullptr),
+    write_high_watermark_(4 * 1024 * 1024), write_low_watermark_(1024 * 1024),
+    slow_consumer_timeout_(30000), ack_delay_(5), dedup_max_entries_(64), dedup_max_bytes_(256 * 1024), next_loop_(0),
+    loops_ready_(0), loops_running_(false) {
 }
 
 ConnectionHandler::~ConnectionHandler() {
+    // stopServer返回时各循环线程已退出，此时才能释放循环
     stopServer();
-    if (loop_) {
-        hloop_stop(loop_);
-        hloop_free(&loop_);
-        loop_ = nullptr;
+    for (LoopContext* ctx : loops_) {
+        if (ctx->loop) {
+            hloop_free(&ctx->loop);
+        }
+        delete ctx;
     }
+    loops_.clear();
+    loop_ = nullptr;
 }
 
 bool ConnectionHandler::initialize(BusinessHandler* handler, ReliableMsgManager* msg_manager) {
-    if (!handler || !msg_manager) {
+    return initialize(handler, std::vector<ReliableMsgManager*>{msg_manager});
+}
+
+bool ConnectionHandler::initialize(BusinessHandler* handler, const std::vector<ReliableMsgManager*>& msg_managers) {
+    if (!handler || msg_managers.empty()) {
         std::cerr << "Invalid handler or message manager" << std::endl;
         return false;
     }
+    for (ReliableMsgManager* msg_manager : msg_managers) {
+        if (!msg_manager) {
+            std::cerr << "Invalid handler or message manager" << std::endl;
+            return false;
+        }
+    }
     
     business_handler_ = handler;
-    reliable_msg_manager_ = msg_manager;
     
-    // 创建事件循环
-    loop_ = hloop_new();
-    if (!loop_) {
-        std::cerr << "Failed to create event loop" << std::endl;
-        return false;
-    }
+    // 业务处理器主动发送的响应（如异步任务结果）通过连接处理器发出
+    business_handler_->setResponseSender([this](int conn_id, MyProtoMsg& response) {
+        return this->sendResponse(conn_id, response);
+    });
+    business_handler_->setChunkSender([this](int conn_id, MyProtoMsg& chunk, bool last, ChunkSentCallback on_sent) {
+        return this->sendStreamChunk(conn_id, chunk, last, on_sent);
+    });
     
-    // 设置事件循环到可靠消息管理器
-    reliable_msg_manager_->setEventLoop(loop_);
-    
-    // 设置重传回调函数
-    reliable_msg_manager_->setRetransmitCallback(
-        [this](int conn_id, const MyProtoMsg& msg) {
-            this->onRetransmitMessage(conn_id, msg);
+    // 为每个可靠消息管理器创建一个事件循环
+    for (size_t i = 0; i < msg_managers.size(); ++i) {
+        LoopContext* ctx = new LoopContext();
+        ctx->index = (int)i;
+        ctx->in_read_callback = false;
+        ctx->flush_scheduled = false;
+        ctx->throttled_clients = 0;
+        ctx->evicted_clients = 0;
+        ctx->reliable_msg_manager = msg_managers[i];
+        ctx->ack_timer = nullptr;
+        
+        // 创建事件循环：不带HLOOP_FLAG_AUTO_FREE，hloop_run返回后循环仍然有效，
+        // 由析构函数在所有循环线程结束后统一释放
+        ctx->loop = hloop_new(0);
+        if (!ctx->loop) {
+            std::cerr << "Failed to create event loop" << std::endl;
+            delete ctx;
+            return false;
         }
-    );
+        // 事件循环的用户数据指向其上下文，回调中通过hevent_loop(io)即可找到所属循环
+        hloop_set_userdata(ctx->loop, ctx);
+        loops_.push_back(ctx);
+        
+        // 心跳发送和超时检查共用一个周期定时器，不再为每个连接创建定时器
+        ctx->wheel_timer = htimer_add(ctx->loop, ConnectionHandler::onWheelTick, 
+                                      ctx->timeout_wheel.tickMs(), INFINITE);
+        hevent_set_userdata((hevent_t*)ctx->wheel_timer, this);
+        
+        // 设置事件循环到可靠消息管理器
+        ctx->reliable_msg_manager->setEventLoop(ctx->loop);
+        
+        // 设置重传回调函数
+        ctx->reliable_msg_manager->setRetransmitCallback(
+            [this, ctx](int conn_id, const PendingMessage& pending) {
+                return this->onRetransmitMessage(ctx, conn_id, pending);
+            }
+        );
+        
+        // 设置发送回调函数，发送窗口打开时由可靠消息管理器调用
+        ctx->reliable_msg_manager->setTransmitCallback(
+            [this, ctx](int conn_id, const PendingMessage& pending) {
+                this->writeSharedFrame(ctx, conn_id, pending.frame, pending.sequence);
+            }
+        );
+        
+        ctx->reliable_msg_manager->startTimeoutCheck();
+    }
     
-    reliable_msg_manager_->startTimeoutCheck();
+    loop_ = loops_[0]->loop;
     setInstance(this); // 设置全局实例
     
+    std::cout << "ConnectionHandler initialized with " << loops_.size() << " event loop(s)"
+              << ", CRC: " << crcImplementation() << std::endl;
     return true;
 }
 
-void ConnectionHandler::onRetransmitMessage(int conn_id, const MyProtoMsg& msg) {
-    // 复制消息对象，准备发送
-    MyProtoMsg retransmit_msg = msg;
-    
+bool ConnectionHandler::onRetransmitMessage(LoopContext* ctx, int conn_id, const PendingMessage& pending) {
     // 找到对应的连接
-    auto it = clients_.find(conn_id);
-    if (it != clients_.end()) {
-        std::cout << "Performing actual retransmit, conn_id: " << conn_id 
-                  << ", sequence: " << msg.head.sequence << std::endl;
-        
-        // 发送重传消息
-        sendMessage(it->second.io, retransmit_msg);
-    } else {
+    auto it = ctx->clients.find(conn_id);
+    if (it == ctx->clients.end()) {
         std::cerr << "Connection not found for retransmit, conn_id: " << conn_id << std::endl;
+        return false;
     }
+    // 客户端不读数据时原消息还在发送队列里，重传只会让积压继续增长；
+    // 跳过时不计重传次数，限流解除后的下一次检测再重传
+    if (!checkBackpressure(ctx, conn_id) || it->second.throttled) {
+        return false;
+    }
+    
+    // 原样写出保存的帧字节，序列号不变，客户端可据此去重
+    return writeSharedFrame(ctx, conn_id, pending.frame, pending.sequence);
 }
 
 bool ConnectionHandler::startServer(int port) {
@@ -78,35 +168,138 @@ bool ConnectionHandler::startServer(int port) {
         return false;
     }
     
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        loops_ready_ = 1;
+        loops_running_ = true;
+    }
+    loops_[0]->tid = std::this_thread::get_id();
+    
+    // 启动其余事件循环线程：每个线程先登记自己的线程ID再运行循环，
+    // 全部登记后才开始接受连接，跨线程按tid判断是否在所属循环内时不会读到未写入的值
+    for (size_t i = 1; i < loops_.size(); ++i) {
+        LoopContext* ctx = loops_[i];
+        ctx->thread = std::thread([this, ctx]() {
+            ctx->tid = std::this_thread::get_id();
+            {
+                std::lock_guard<std::mutex> lock(state_mutex_);
+                ++loops_ready_;
+            }
+            state_cv_.notify_all();
+            hloop_run(ctx->loop);
+        });
+    }
+    {
+        std::unique_lock<std::mutex> lock(state_mutex_);
+        state_cv_.wait(lock, [this]() { return loops_ready_ == loops_.size(); });
+    }
+    
     // 创建TCP服务器
-    server_ = hloop_create_tcp_server(loop_, "0.0.0.0", port, ConnectionHandler::onConnection);
-    if (!server_) {
+    server_ = hloop_create_tcp_server(loop_, "0.0.0.0", port, ConnectionHandler::onAccept);
+    if (server_) {
+        // 设置用户数据，方便回调函数访问
+        hio_set_context(server_, this);
+        std::cout << "Server started on port " << port << ", event loops: " << loops_.size() << std::endl;
+        
+        // 在当前线程运行主事件循环，stopServer让所有循环退出后返回
+        hloop_run(loop_);
+    } else {
         std::cerr << "Failed to create TCP server on port " << port << std::endl;
-        return false;
+        for (size_t i = 1; i < loops_.size(); ++i) {
+            LoopContext* ctx = loops_[i];
+            runInLoop(ctx->loop, [ctx]() {
+                hloop_stop(ctx->loop);
+            });
+        }
     }
     
-    // 设置用户数据，方便回调函数访问
-    hio_set_context(server_, this);
+    // 回收其余循环线程，之后各循环的状态只由当前线程访问
+    for (size_t i = 1; i < loops_.size(); ++i) {
+        if (loops_[i]->thread.joinable()) {
+            loops_[i]->thread.join();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        loops_running_ = false;
+    }
+    state_cv_.notify_all();
     
-    std::cout << "Server started on port " << port << std::endl;
+    return server_ != nullptr;
+}
+
+void ConnectionHandler::stopServer() {
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    if (!loops_running_) {
+        // 循环没有在运行（未启动或已全部退出），在当前线程直接清理
+        lock.unlock();
+        if (server_) {
+            hio_close(server_);
+            server_ = nullptr;
+        }
+        for (LoopContext* ctx : loops_) {
+            closeClients(ctx);
+        }
+        return;
+    }
+    lock.unlock();
     
-    // 启动事件循环
-    hloop_run(loop_);
+    // 每个循环在自己的线程内关闭监听和客户端连接后退出，0号循环退出后startServer回收其余线程
+    for (LoopContext* ctx : loops_) {
+        runInLoop(ctx->loop, [this, ctx]() {
+            if (ctx->loop == loop_ && server_) {
+                hio_close(server_);
+                server_ = nullptr;
+            }
+            closeClients(ctx);
+            hloop_stop(ctx->loop);
+        });
+    }
     
-    return true;
+    // 在事件循环线程内调用时不能等待自己退出
+    for (LoopContext* ctx : loops_) {
+        if (ctx->tid == std::this_thread::get_id()) {
+            return;
+        }
+    }
+    lock.lock();
+    state_cv_.wait(lock, [this]() { return !loops_running_; });
 }
 
-void ConnectionHandler::stopServer() {
-    if (server_) {
-        hio_close(server_);
-        server_ = nullptr;
+void ConnectionHandler::closeClients(LoopContext* ctx) {
+    // hio_close会同步触发onClose并修改clients表，先复制一份再关闭
+    std::vector<hio_t*> ios;
+    ios.reserve(ctx->clients.size());
+    for (auto& pair : ctx->clients) {
+        ios.push_back(pair.second.io);
+    }
+    for (hio_t* io : ios) {
+        hio_close(io);
     }
+    ctx->clients.clear();
+}
+
+void ConnectionHandler::runInLoop(hloop_t* loop, std::function<void()> task) {
+    // hloop_post_event会拷贝事件结构体，任务对象放在堆上由回调负责释放
+    hevent_t ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.cb = ConnectionHandler::onLoopEvent;
+    hevent_set_userdata(&ev, new std::function<void()>(std::move(task)));
+    hloop_post_event(loop, &ev);
+}
+
+void ConnectionHandler::onLoopEvent(hevent_t* ev) {
+    std::function<void()>* task = (std::function<void()>*)hevent_userdata(ev);
+    if (!task) return;
     
-    // 关闭所有客户端连接
-    for (auto& pair : clients_) {
-        hio_close(pair.second.io);
+    try {
+        (*task)();
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] Exception in loop task: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "[ERROR] Unknown exception in loop task" << std::endl;
     }
-    clients_.clear();
+    delete task;
 }
 
 hio_t* ConnectionHandler::connectToServer(const char* host, int port) {
@@ -127,46 +320,452 @@ hio_t* ConnectionHandler::connectToServer(const char* host, int port) {
     return io;
 }
 
-bool ConnectionHandler::sendMessage(hio_t* conn, MyProtoMsg& msg) {
-    if (!conn || !reliable_msg_manager_) {
+bool ConnectionHandler::sendMessage(hio_t* conn, MyProtoMsg& msg, DeliveryClass delivery) {
+    if (!conn) {
+        return false;
+    }
+    
+    LoopContext* ctx = getLoopContext(conn);
+    if (!ctx || !ctx->reliable_msg_manager) {
         return false;
     }
     
+    // 不需要确认的消息沿用调用方设置的序列号直接写出，不进入发送窗口
+    if (delivery != DeliveryClass::RELIABLE) {
+        return writeMessage(ctx, conn, msg);
+    }
+    
     int conn_id = getConnectionId(conn);
+    auto it = ctx->clients.find(conn_id);
+    if (it == ctx->clients.end()) {
+        return false;
+    }
     
-    // 生成序列号
-    msg.head.sequence = reliable_msg_manager_->generateSequence(conn_id);
+    // 按连接的编码方式编码一次，发送窗口只保存帧字节，重传时原样写出
+    MyProtoSharedFrame frame;
+    setMessageCodec(it->second, msg);
+    if (!proto_encoder_.encodeShared(&msg, frame)) {
+        return false;
+    }
     
-    // 保存待发送消息
-    reliable_msg_manager_->savePendingMessage(conn_id, msg);
+    // 分配序列号并放入发送窗口，窗口未满时立即写出，否则排队
+    return ctx->reliable_msg_manager->sendReliable(conn_id, frame, &msg.head.sequence);
+}
+
+void ConnectionHandler::setMessageCodec(const ConnectionInfo& conn, MyProtoMsg& msg) {
+    // 按连接协商的编码方式编码消息体，客户端支持时允许压缩
+    msg.head.flags = (msg.head.flags & ~(MY_PROTO_CODEC_MASK | MY_PROTO_FLAG_COMPRESSED)) | conn.codec;
+    if (conn.accept_compression) {
+        msg.head.flags |= MY_PROTO_FLAG_COMPRESSED;
+    }
+}
+
+bool ConnectionHandler::writeMessage(LoopContext* ctx, hio_t* io, MyProtoMsg& msg) {
+    int conn_id = getConnectionId(io);
+    auto it = ctx->clients.find(conn_id);
+    if (it == ctx->clients.end()) {
+        return false;
+    }
+    ConnectionInfo& conn = it->second;
+    setMessageCodec(conn, msg);
     
-    // 编码消息
-    uint32_t len = 0;
-    uint8_t* data = proto_encoder_.encode(&msg, len);
-    if (!data) {
+    // 直接编码追加到连接的输出缓冲区
+    if (!proto_encoder_.encodeAppend(&msg, conn.output_buffer)) {
+        return false;
+    }
+    return scheduleFlush(ctx, conn_id, conn);
+}
+
+bool ConnectionHandler::writeSharedFrame(LoopContext* ctx, int conn_id, const MyProtoSharedFrame& frame, uint32_t sequence) {
+    auto it = ctx->clients.find(conn_id);
+    if (it == ctx->clients.end() || !frame.data) {
         return false;
     }
+    ConnectionInfo& conn = it->second;
+    proto_encoder_.appendShared(frame, sequence, conn.output_buffer);
+    return scheduleFlush(ctx, conn_id, conn);
+}
+
+bool ConnectionHandler::scheduleFlush(LoopContext* ctx, int conn_id, ConnectionInfo& conn) {
+    // 累计数据较多时立即写出
+    if (conn.output_buffer.size() >= MAX_COALESCE_BYTES) {
+        flushConnection(ctx, conn_id);
+        return checkBackpressure(ctx, conn_id);
+    }
+    
+    if (!conn.output_dirty) {
+        conn.output_dirty = true;
+        ctx->dirty_connections.push_back(conn_id);
+    }
+    
+    // 读回调结束时会统一写出；其他场景（工作线程回投的响应、定时器触发的心跳和重传）
+    // 投递一个写出任务，本轮已投递的事件处理完之后再一起写出
+    if (!ctx->in_read_callback && !ctx->flush_scheduled) {
+        ctx->flush_scheduled = true;
+        runInLoop(ctx->loop, [this, ctx]() {
+            ctx->flush_scheduled = false;
+            flushPendingOutput(ctx);
+        });
+    }
+    return true;
+}
+
+void ConnectionHandler::flushConnection(LoopContext* ctx, int conn_id) {
+    auto it = ctx->clients.find(conn_id);
+    if (it == ctx->clients.end()) {
+        return;
+    }
+    ConnectionInfo& conn = it->second;
+    conn.output_dirty = false;
+    if (conn.output_buffer.empty()) {
+        return;
+    }
+    
+    // 写出时连接可能因出错被同步关闭，先把数据交换到循环的发送缓冲区，写出后不再访问conn
+    std::string& out = ctx->write_buffer;
+    out.swap(conn.output_buffer);
+    hio_t* io = conn.io;
+    
+    // 一次写出所有合并的帧（未能立即写出的部分由libhv拷贝到写队列）
+    hio_write(io, out.data(), out.size());
+    
+    out.clear();
+    if (out.capacity() > MAX_IDLE_BUFFER_CAPACITY) {
+        std::string().swap(out);
+    }
+    
+    checkBackpressure(ctx, conn_id);
+}
+
+bool ConnectionHandler::checkBackpressure(LoopContext* ctx, int conn_id) {
+    auto it = ctx->clients.find(conn_id);
+    if (it == ctx->clients.end()) {
+        return false;
+    }
+    ConnectionInfo& conn = it->second;
+    size_t pending = hio_write_bufsize(conn.io) + conn.output_buffer.size();
+    
+    if (!conn.throttled && pending > write_high_watermark_) {
+        // 客户端消费跟不上，暂停读取它的请求，避免继续为它产生响应
+        uint64_t now = hloop_now_ms(ctx->loop);
+        conn.throttled = true;
+        conn.throttled_since = now;
+        ctx->throttled_clients++;
+        hio_read_stop(conn.io);
+        
+        // 暂停读取后收不到对端的心跳，空闲超时改为慢消费者超时，由时间轮推进时检查，
+        // 不依赖之后是否还有写出
+        ctx->heartbeat_wheel.cancel(conn_id);
+        ctx->timeout_wheel.cancel(conn_id);
+        ctx->throttle_wheel.schedule(conn_id, now + slow_consumer_timeout_);
+        std::cout << "[WARN] Client throttled, conn_id: " << conn_id 
+                  << ", pending write bytes: " << pending << std::endl;
+    }
+    return true;
+}
+
+void ConnectionHandler::onWriteComplete(hio_t* io, const void* /*buf*/, int /*writebytes*/) {
+    ConnectionHandler* handler = (ConnectionHandler*)hio_context(io);
+    if (!handler) return;
+    
+    // 只有写队列回落到低水位以下才需要查表
+    if (hio_write_bufsize(io) > handler->write_low_watermark_) return;
+    
+    LoopContext* ctx = handler->getLoopContext(io);
+    if (!ctx) return;
+    auto it = ctx->clients.find(handler->getConnectionId(io));
+    if (it == ctx->clients.end() || !it->second.throttled) return;
+    
+    ConnectionInfo& conn = it->second;
+    if (conn.output_buffer.size() + hio_write_bufsize(io) > handler->write_low_watermark_) return;
+    
+    conn.throttled = false;
+    ctx->throttled_clients--;
+    hio_read(io);
+    std::cout << "[DEBUG] Client resumed, conn_id: " << it->first << std::endl;
+    
+    // 恢复读取后重新开始心跳和空闲超时计时
+    uint64_t now = hloop_now_ms(ctx->loop);
+    ctx->throttle_wheel.cancel(it->first);
+    ctx->heartbeat_wheel.schedule(it->first, now + handler->heartbeat_interval_);
+    ctx->timeout_wheel.schedule(it->first, now + handler->heartbeat_timeout_);
+    
+    // 让等待中的流式响应继续产生分片
+    std::vector<std::function<void(bool)>> waiters;
+    waiters.swap(conn.chunk_waiters);
+    for (auto& on_sent : waiters) {
+        on_sent(true);
+    }
+}
+
+int ConnectionHandler::getThrottledClientCount() const {
+    int count = 0;
+    for (LoopContext* ctx : loops_) {
+        count += ctx->throttled_clients.load();
+    }
+    return count;
+}
+
+uint64_t ConnectionHandler::getEvictedClientCount() const {
+    uint64_t count = 0;
+    for (LoopContext* ctx : loops_) {
+        count += ctx->evicted_clients.load();
+    }
+    return count;
+}
+
+void ConnectionHandler::flushPendingOutput(LoopContext* ctx) {
+    // 写出过程中可能再次产生待写数据，交换出来再遍历
+    std::vector<int> dirty;
+    dirty.swap(ctx->dirty_connections);
+    for (int conn_id : dirty) {
+        flushConnection(ctx, conn_id);
+    }
+}
+
+bool ConnectionHandler::sendMessage(int conn_id, MyProtoMsg& msg, DeliveryClass delivery) {
+    LoopContext* ctx = findLoopContext(conn_id);
+    if (!ctx) {
+        return false;
+    }
+    
+    // 在所属事件循环线程内直接发送
+    if (ctx->tid == std::this_thread::get_id()) {
+        auto it = ctx->clients.find(conn_id);
+        if (it == ctx->clients.end()) {
+            return false;
+        }
+        return sendMessage(it->second.io, msg, delivery);
+    }
     
-    // 发送数据
-    int n = hio_write(conn, data, len);
-    delete[] data;
+    // 其他线程投递到所属事件循环发送
+    MyProtoMsg cloned_msg = msg;
+    runInLoop(ctx->loop, [this, ctx, conn_id, cloned_msg, delivery]() mutable {
+        auto it = ctx->clients.find(conn_id);
+        if (it != ctx->clients.end()) {
+            sendMessage(it->second.io, cloned_msg, delivery);
+        }
+    });
+    return true;
+}
+
+bool ConnectionHandler::sendResponse(hio_t* conn, MyProtoMsg& response) {
+    if (!conn) {
+        return false;
+    }
+    
+    LoopContext* ctx = getLoopContext(conn);
+    if (!ctx) {
+        return false;
+    }
+    
+    // 响应沿用请求的序列号，不重新分配，也不进入重传队列：
+    // 客户端按序列号匹配请求与响应，收不到响应时由客户端重发请求
+    int conn_id = getConnectionId(conn);
     
-    return n == len;
+    // 请求记在去重窗口中时保存编码好的响应帧，重发的请求直接重放
+    auto it = ctx->clients.find(conn_id);
+    if (it != ctx->clients.end()) {
+        ConnectionInfo& info = it->second;
+        auto entry_it = info.dedup_entries.find(response.head.sequence);
+        if (entry_it != info.dedup_entries.end() && entry_it->second.server == response.head.server &&
+            !entry_it->second.response.data) {
+            MyProtoSharedFrame frame;
+            setMessageCodec(info, response);
+            if (!proto_encoder_.encodeShared(&response, frame)) {
+                return false;
+            }
+            entry_it->second.response = frame;
+            info.dedup_bytes += frame.data->size();
+            trimDedupWindow(info);
+            return writeSharedFrame(ctx, conn_id, frame, response.head.sequence);
+        }
+    }
+    return writeMessage(ctx, conn, response);
 }
 
-bool ConnectionHandler::sendMessage(int conn_id, MyProtoMsg& msg) {
-    auto it = clients_.find(conn_id);
-    if (it == clients_.end()) {
+bool ConnectionHandler::sendStreamChunk(int conn_id, MyProtoMsg& chunk, bool last, std::function<void(bool)> on_sent) {
+    LoopContext* ctx = findLoopContext(conn_id);
+    if (!ctx) {
         return false;
     }
-    return sendMessage(it->second.io, msg);
+    
+    // 没有工作线程池时处理函数在循环线程内执行，分片直接处理才能先于它的最终响应；
+    // 延迟的最终响应可能在分片写出回调中发出，总是投递到循环中处理，避免在按序写出的过程中重入
+    if (!last && ctx->tid == std::this_thread::get_id()) {
+        deliverStreamChunk(ctx, conn_id, chunk, last, on_sent);
+        return true;
+    }
+    
+    // 分片可能很大，移入任务而不是拷贝
+    std::shared_ptr<MyProtoMsg> moved_chunk = std::make_shared<MyProtoMsg>(std::move(chunk));
+    runInLoop(ctx->loop, [this, ctx, conn_id, moved_chunk, last, on_sent]() {
+        deliverStreamChunk(ctx, conn_id, *moved_chunk, last, on_sent);
+    });
+    return true;
 }
 
-void ConnectionHandler::broadcastMessage(MyProtoMsg& msg) {
-    for (auto& pair : clients_) {
-        MyProtoMsg cloned_msg = msg;
-        sendMessage(pair.second.io, cloned_msg);
+void ConnectionHandler::deliverStreamChunk(LoopContext* ctx, int conn_id, MyProtoMsg& chunk, bool last, std::function<void(bool)> on_sent) {
+    auto it = ctx->clients.find(conn_id);
+    if (it == ctx->clients.end()) {
+        if (!last) {
+            on_sent(false);
+        }
+        return;
+    }
+    ConnectionInfo& conn = it->second;
+    
+    // 分片与请求的序列号相同，按序列号找到所属请求的回复位置（最早的同序列号且尚未完成的请求）
+    uint64_t slot = conn.next_response_slot;
+    bool found = false;
+    for (uint32_t sequence : conn.slot_sequences) {
+        if (sequence == chunk.head.sequence && conn.ready_responses.find(slot) == conn.ready_responses.end()) {
+            found = true;
+            break;
+        }
+        slot++;
+    }
+    if (!found) {
+        // 所属请求已经回复，最终响应之后不再写出分片
+        if (!last) {
+            on_sent(false);
+        }
+        return;
     }
+    
+    // 延迟的最终响应填入该请求的回复位置，按请求顺序在它的分片之后发出
+    if (last) {
+        onRequestCompleted(ctx, conn_id, slot, std::make_shared<MyProtoMsg>(std::move(chunk)));
+        return;
+    }
+    
+    // 前面还有请求未回复时先暂存，分片不能插到前面请求的响应之前
+    if (slot != conn.next_response_slot) {
+        HeldChunk held;
+        held.chunk = std::make_shared<MyProtoMsg>(std::move(chunk));
+        held.on_sent = on_sent;
+        conn.held_chunks[slot].push_back(held);
+        return;
+    }
+    writeStreamChunk(ctx, conn_id, chunk, on_sent);
+}
+
+bool ConnectionHandler::writeStreamChunk(LoopContext* ctx, int conn_id, MyProtoMsg& chunk, std::function<void(bool)> on_sent) {
+    auto it = ctx->clients.find(conn_id);
+    if (it == ctx->clients.end()) {
+        on_sent(false);
+        return false;
+    }
+    
+    // 分片不记入去重窗口，重发的请求只重放最终响应
+    bool written = writeMessage(ctx, it->second.io, chunk);
+    
+    // 写出时可能因消费过慢被断开
+    it = ctx->clients.find(conn_id);
+    if (it == ctx->clients.end()) {
+        on_sent(false);
+        return false;
+    }
+    
+    // 客户端读得慢时推迟确认，写入方在途分片达到上限后就会停下来
+    if (!written) {
+        on_sent(false);
+    } else if (it->second.throttled) {
+        it->second.chunk_waiters.push_back(on_sent);
+    } else {
+        on_sent(true);
+    }
+    return true;
+}
+
+bool ConnectionHandler::sendResponse(int conn_id, MyProtoMsg& response) {
+    LoopContext* ctx = findLoopContext(conn_id);
+    if (!ctx) {
+        return false;
+    }
+    
+    // 在所属事件循环线程内直接发送
+    if (ctx->tid == std::this_thread::get_id()) {
+        auto it = ctx->clients.find(conn_id);
+        if (it == ctx->clients.end()) {
+            return false;
+        }
+        return sendResponse(it->second.io, response);
+    }
+    
+    // 其他线程投递到所属事件循环发送
+    MyProtoMsg cloned_response = response;
+    runInLoop(ctx->loop, [this, ctx, conn_id, cloned_response]() mutable {
+        auto it = ctx->clients.find(conn_id);
+        if (it != ctx->clients.end()) {
+            sendResponse(it->second.io, cloned_response);
+        }
+    });
+    return true;
+}
+
+void ConnectionHandler::broadcastMessage(const MyProtoMsg& msg) {
+    // 各连接共享编码结果，发送时只改写序列号和CRC；没有连接用到的编码方式不序列化
+    std::shared_ptr<BroadcastFrames> frames = std::make_shared<BroadcastFrames>();
+    frames->msg = msg;
+    
+    for (LoopContext* ctx : loops_) {
+        runInLoop(ctx->loop, [this, ctx, frames]() {
+            // 本循环已取到的帧，每种编码方式只加一次锁
+            const MyProtoSharedFrame* cached[BroadcastFrames::VARIANTS] = {};
+            bool fetched[BroadcastFrames::VARIANTS] = {};
+
+            // 写出过程中连接可能因背压被断开，先取出连接ID
+            std::vector<int> conn_ids;
+            conn_ids.reserve(ctx->clients.size());
+            for (auto& pair : ctx->clients) {
+                conn_ids.push_back(pair.first);
+            }
+            
+            for (int conn_id : conn_ids) {
+                auto it = ctx->clients.find(conn_id);
+                if (it == ctx->clients.end()) {
+                    continue;
+                }
+                // 选用与连接编码方式相同的那一份，发送窗口中各连接引用同一份帧字节；
+                // 窗口已满的连接先排队，窗口打开后发送
+                const ConnectionInfo& conn = it->second;
+                int variant = (conn.codec >> 4) + (conn.accept_compression ? MY_PROTO_CODEC_COUNT : 0);
+                if (!fetched[variant]) {
+                    fetched[variant] = true;
+                    cached[variant] = frames->frame(variant, proto_encoder_);
+                }
+                if (cached[variant]) {
+                    ctx->reliable_msg_manager->sendReliable(conn_id, *cached[variant]);
+                }
+            }
+        });
+    }
+}
+
+void ConnectionHandler::onAccept(hio_t* io) {
+    // 获取全局实例
+    ConnectionHandler* handler = getInstance();
+    if (!handler || handler->loops_.empty()) {
+        std::cerr << "[ERROR] No ConnectionHandler instance available" << std::endl;
+        hio_close(io);
+        return;
+    }
+    
+    // 轮询选择事件循环
+    uint32_t index = handler->next_loop_.fetch_add(1) % handler->loops_.size();
+    LoopContext* ctx = handler->loops_[index];
+    if (ctx->loop == hevent_loop(io)) {
+        onConnection(io);
+        return;
+    }
+    
+    // 从主循环摘下连接，交给目标事件循环接管
+    hio_detach(io);
+    runInLoop(ctx->loop, [ctx, io]() {
+        hio_attach(ctx->loop, io);
+        ConnectionHandler::onConnection(io);
+    });
 }
 
 void ConnectionHandler::onConnection(hio_t* io) {
@@ -178,9 +777,16 @@ void ConnectionHandler::onConnection(hio_t* io) {
         std::cerr << "[ERROR] No ConnectionHandler instance available" << std::endl;
         return;
     }
+    LoopContext* ctx = handler->getLoopContext(io);
+    if (!ctx) {
+        std::cerr << "[ERROR] Connection is not attached to a known event loop" << std::endl;
+        hio_close(io);
+        return;
+    }
     // 设置连接的回调函数
     hio_setcb_close(io, ConnectionHandler::onClose);
     hio_setcb_read(io, ConnectionHandler::onMessage);
+    hio_setcb_write(io, ConnectionHandler::onWriteComplete);
     // 设置新连接的上下文
     hio_set_context(io, handler);
     // 开始读取数据
@@ -191,22 +797,32 @@ void ConnectionHandler::onConnection(hio_t* io) {
     // 创建连接信息
     ConnectionInfo conn_info;
     conn_info.io = io;
-    conn_info.last_heartbeat_time = time(nullptr);
-    
-    // 创建超时定时器
-    conn_info.timeout_timer = htimer_add(handler->loop_, ConnectionHandler::onHeartbeatTimeout, 
-                                         handler->heartbeat_timeout_, 1);
-    // 设置timer->data为handler，priv_data为conn_id
-   hevent_set_userdata((hevent_t*)conn_info.timeout_timer, handler);
-   ((hevent_t*)(conn_info.timeout_timer))->privdata = (void*)(intptr_t)conn_id;
+    conn_info.last_active_time = time(nullptr);
+    conn_info.decoder = std::make_shared<MyProtoDecode>();
+    conn_info.next_request_slot = 0;
+    conn_info.next_response_slot = 0;
+    conn_info.output_dirty = false;
+    conn_info.codec = MY_PROTO_CODEC_JSON;
+    conn_info.accept_compression = false;
+    conn_info.throttled = false;
+    conn_info.throttled_since = 0;
+    conn_info.dedup_bytes = 0;
+    conn_info.dedup_started = false;
+    conn_info.dedup_high = 0;
     
-    handler->clients_[conn_id] = conn_info;
+    ctx->clients[conn_id] = conn_info;
+    {
+        std::lock_guard<std::mutex> lock(handler->conn_loops_mutex_);
+        handler->conn_loops_[conn_id] = ctx;
+    }
     
-    // 设置心跳
-    hio_set_heartbeat(io, handler->heartbeat_interval_, ConnectionHandler::sendHeartbeat);
+    // 登记心跳发送时间和超时时间
+    uint64_t now = hloop_now_ms(ctx->loop);
+    ctx->heartbeat_wheel.schedule(conn_id, now + handler->heartbeat_interval_);
+    ctx->timeout_wheel.schedule(conn_id, now + handler->heartbeat_timeout_);
     
-    std::cout << "[DEBUG] Client connected, id: " << conn_id << ", heartbeat interval: " 
-              << handler->heartbeat_interval_ << "ms" << std::endl;
+    std::cout << "[DEBUG] Client connected, id: " << conn_id << ", loop: " << ctx->index
+              << ", heartbeat interval: " << handler->heartbeat_interval_ << "ms" << std::endl;
     std::cout.flush(); // 强制刷新输出
 }
 
@@ -215,18 +831,37 @@ void ConnectionHandler::onClose(hio_t* io) {
     if (!handler) return;
     
     int conn_id = handler->getConnectionId(io);
-    auto it = handler->clients_.find(conn_id);
-    if (it != handler->clients_.end()) {
-        // 取消超时定时器
-        if (it->second.timeout_timer) {
-            htimer_del(it->second.timeout_timer);
+    LoopContext* ctx = handler->getLoopContext(io);
+    if (!ctx) return;
+    
+    auto it = ctx->clients.find(conn_id);
+    if (it != ctx->clients.end()) {
+        // 从时间轮中移除
+        ctx->heartbeat_wheel.cancel(conn_id);
+        ctx->timeout_wheel.cancel(conn_id);
+        ctx->throttle_wheel.cancel(conn_id);
+        if (it->second.throttled) {
+            ctx->throttled_clients--;
+        }
+        // 通知等待中的流式响应停止
+        for (auto& on_sent : it->second.chunk_waiters) {
+            on_sent(false);
+        }
+        for (auto& slot_chunks : it->second.held_chunks) {
+            for (auto& held : slot_chunks.second) {
+                held.on_sent(false);
+            }
         }
         
-        handler->clients_.erase(it);
+        ctx->clients.erase(it);
+    }
+    {
+        std::lock_guard<std::mutex> lock(handler->conn_loops_mutex_);
+        handler->conn_loops_.erase(conn_id);
     }
     
-    if (handler->reliable_msg_manager_) {
-        handler->reliable_msg_manager_->removeConnection(conn_id);
+    if (ctx->reliable_msg_manager) {
+        ctx->reliable_msg_manager->removeConnection(conn_id);
     }
     std::cout << "Client disconnected, id: " << conn_id << std::endl;
 }
@@ -248,26 +883,52 @@ void ConnectionHandler::onMessage(hio_t* io, void* buf, int readbytes) {
         std::cerr << "[ERROR] handler is null in onMessage!" << std::endl;
         return;
     }
+    LoopContext* ctx = handler->getLoopContext(io);
+    if (!ctx) {
+        std::cerr << "[ERROR] Connection is not attached to a known event loop" << std::endl;
+        return;
+    }
+    int conn_id = handler->getConnectionId(io);
+    auto conn_it = ctx->clients.find(conn_id);
+    if (conn_it == ctx->clients.end()) {
+        std::cerr << "[ERROR] Unknown connection in onMessage, conn_id: " << conn_id << std::endl;
+        return;
+    }
+    // 持有解码器引用，处理消息过程中连接被关闭也不会释放解码器
+    std::shared_ptr<MyProtoDecode> decoder = conn_it->second.decoder;
     
+    // 读回调期间产生的ACK、响应等帧先缓存，回调结束时合并写出
+    ctx->in_read_callback = true;
+    bool closed = false;
     try {
         // 解析协议消息
-        std::cout << "[DEBUG] Calling proto_decoder_.parser()" << std::endl;
-        bool parse_result = handler->proto_decoder_.parser(buf, readbytes);
+        std::cout << "[DEBUG] Calling decoder->parser()" << std::endl;
+        bool parse_result = decoder->parser(buf, readbytes);
         std::cout << "[DEBUG] parser() returned: " << (parse_result ? "true" : "false") << std::endl;
         
-        if (parse_result) {
-            std::cout << "[DEBUG] Checking message queue, empty: " << (handler->proto_decoder_.empty() ? "true" : "false") << std::endl;
-            // 处理所有解析出的消息
-            while (!handler->proto_decoder_.empty()) {
-                std::cout << "[DEBUG] Found message in queue, calling processMessage" << std::endl;
-                std::shared_ptr<MyProtoMsg> msg = handler->proto_decoder_.front();
-                if (!msg) {
-                    std::cerr << "[ERROR] Message pointer is null!" << std::endl;
-                    handler->proto_decoder_.pop();
-                    continue;
-                }
-                handler->processMessage(io, msg);
-                handler->proto_decoder_.pop();
+        // 任何完整的帧（数据、ACK、心跳）都说明连接是活的
+        if (!decoder->empty()) {
+            handler->refreshActivity(ctx, conn_id);
+        }
+        
+        // 解析失败时丢弃的只是出错的那一帧，之前已解析出的消息仍然需要处理
+        std::cout << "[DEBUG] Checking message queue, empty: " << (decoder->empty() ? "true" : "false") << std::endl;
+        // 处理所有解析出的消息
+        while (!decoder->empty()) {
+            std::cout << "[DEBUG] Found message in queue, calling processMessage" << std::endl;
+            std::shared_ptr<MyProtoMsg> msg = decoder->front();
+            decoder->pop();
+            if (!msg) {
+                std::cerr << "[ERROR] Message pointer is null!" << std::endl;
+                continue;
+            }
+            handler->processMessage(io, msg);
+            
+            // 处理过程中连接可能已被关闭
+            if (ctx->clients.find(conn_id) == ctx->clients.end()) {
+                decoder->clear();
+                closed = true;
+                break;
             }
         }
     } catch (const std::exception& e) {
@@ -276,6 +937,19 @@ void ConnectionHandler::onMessage(hio_t* io, void* buf, int readbytes) {
         std::cerr << "[ERROR] Unknown exception in onMessage" << std::endl;
     }
     
+    // 一次写出本次读回调产生的所有帧
+    ctx->in_read_callback = false;
+    handler->flushPendingOutput(ctx);
+    if (closed) {
+        return;
+    }
+    
+    // 被限流的连接保持暂停读取，等写队列回落后由onWriteComplete恢复
+    conn_it = ctx->clients.find(conn_id);
+    if (conn_it == ctx->clients.end() || conn_it->second.throttled) {
+        return;
+    }
+    
     // 继续读取数据
     std::cout << "[DEBUG] Calling hio_read to continue reading" << std::endl;
     hio_read(io);
@@ -285,17 +959,16 @@ void ConnectionHandler::onMessage(hio_t* io, void* buf, int readbytes) {
 void ConnectionHandler::processMessage(hio_t* io, std::shared_ptr<MyProtoMsg> msg) {
     try {
         int conn_id = getConnectionId(io);
+        LoopContext* ctx = getLoopContext(io);
+        if (!ctx) {
+            std::cerr << "[ERROR] Connection is not attached to a known event loop" << std::endl;
+            return;
+        }
         
         // 处理心跳请求消息
         if (msg->head.type == MY_PROTO_TYPE_HEARTBEAT) {
             std::cout << "[DEBUG] Received heartbeat request, conn_id: " << conn_id << std::endl;
             
-            // 更新最后心跳时间
-            auto it = clients_.find(conn_id);
-            if (it != clients_.end()) {
-                it->second.last_heartbeat_time = time(nullptr);
-            }
-            
             // 发送心跳响应
             MyProtoMsg heartbeat_ack;
             heartbeat_ack.head.version = msg->head.version;
@@ -304,31 +977,48 @@ void ConnectionHandler::processMessage(hio_t* io, std::shared_ptr<MyProtoMsg> ms
             heartbeat_ack.head.type = MY_PROTO_TYPE_HEARTBEAT_ACK;
             heartbeat_ack.body = {"timestamp", time(nullptr)};
             
-            sendMessage(io, heartbeat_ack);
+            // 心跳响应丢失时对端下个间隔会再发心跳，不需要确认和重传
+            sendMessage(io, heartbeat_ack, DeliveryClass::UNRELIABLE);
             return;
         }
         
         // 处理心跳响应消息
         if (msg->head.type == MY_PROTO_TYPE_HEARTBEAT_ACK) {
             std::cout << "[DEBUG] Received heartbeat response, conn_id: " << conn_id << std::endl;
-            
-            // 更新最后心跳时间
-            auto it = clients_.find(conn_id);
-            if (it != clients_.end()) {
-                it->second.last_heartbeat_time = time(nullptr);
-            }
+            // 活跃时间已在onMessage中刷新
             return;
         }
         
         // 处理确认消息
         if (msg->head.type == MY_PROTO_TYPE_ACK) {
             std::cout << "[DEBUG] Processing confirmation message" << std::endl;
-            // 处理消息确认
-            if (reliable_msg_manager_) {
-                reliable_msg_manager_->processConfirmation(conn_id, msg->head.sequence);
+            // 处理消息确认：消息体带ack时为累计确认（序列号不超过ack的消息全部确认），
+            // 带sack时逐段确认[[first, last], ...]；都没有时只确认消息头中的序列号
+            if (ctx->reliable_msg_manager) {
+                const json& body = msg->body;
+                auto ack = body.is_object() ? body.find("ack") : body.end();
+                auto sack = body.is_object() ? body.find("sack") : body.end();
+                bool extended = false;
+                if (ack != body.end() && ack->is_number_unsigned()) {
+                    ctx->reliable_msg_manager->processCumulativeConfirmation(conn_id, ack->get<uint32_t>());
+                    extended = true;
+                }
+                if (sack != body.end() && sack->is_array()) {
+                    for (const json& range : *sack) {
+                        if (range.is_array() && range.size() == 2 &&
+                            range[0].is_number_unsigned() && range[1].is_number_unsigned()) {
+                            ctx->reliable_msg_manager->processRangeConfirmation(conn_id,
+                                range[0].get<uint32_t>(), range[1].get<uint32_t>());
+                        }
+                    }
+                    extended = true;
+                }
+                if (!extended) {
+                    ctx->reliable_msg_manager->processConfirmation(conn_id, msg->head.sequence);
+                }
                 std::cout << "[DEBUG] Confirmation processed for sequence: " << msg->head.sequence << std::endl;
             } else {
-                std::cerr << "[WARN] reliable_msg_manager_ is null" << std::endl;
+                std::cerr << "[WARN] reliable_msg_manager is null" << std::endl;
             }
             return;
         }
@@ -336,28 +1026,26 @@ void ConnectionHandler::processMessage(hio_t* io, std::shared_ptr<MyProtoMsg> ms
         // 处理数据消息
         if (business_handler_) {
             std::cout << "[DEBUG] Processing data message, calling business_handler_->handleMessage" << std::endl;
-            // 创建确认消息
-            MyProtoMsg ack_msg;
-            ack_msg.head.version = msg->head.version;
-            ack_msg.head.server = msg->head.server;
-            ack_msg.head.sequence = msg->head.sequence;
-            ack_msg.head.type = 1; // 确认消息类型
-            ack_msg.body = json::object();
+            // 客户端用哪种编码发请求，之后发给它的消息就用哪种编码；声明能解压的客户端才压缩
+            auto conn_it = ctx->clients.find(conn_id);
+            if (conn_it != ctx->clients.end()) {
+                conn_it->second.codec = msg->head.flags & MY_PROTO_CODEC_MASK;
+                conn_it->second.accept_compression = (msg->head.flags & MY_PROTO_FLAG_ACCEPT_COMPRESSED) != 0;
+            }
             
-            // 发送确认消息
-            uint32_t len = 0;
-            uint8_t* ack_data = proto_encoder_.encode(&ack_msg, len);
-            if (ack_data) {
-                hio_write(io, ack_data, len);
-                std::cout << "[DEBUG] Sent acknowledgment message, len: " << len << std::endl;
-                delete[] ack_data;
-            } else {
-                std::cerr << "[ERROR] Failed to encode acknowledgment message" << std::endl;
+            // 确认延迟发送：响应在延迟时间内发出时由响应捎带确认，否则由定时器合并确认。
+            // 幂等读请求不单独确认，响应本身就是确认，丢失时客户端重新请求，重新执行也没有副作用
+            DeliveryClass delivery = serviceDelivery(msg->head.server);
+            if (delivery == DeliveryClass::RELIABLE && conn_it != ctx->clients.end() &&
+                replayDuplicate(ctx, conn_id, conn_it->second, msg->head)) {
+                return;
+            }
+            if (delivery != DeliveryClass::AT_MOST_ONCE) {
+                queueAck(ctx, conn_id, msg->head);
             }
             
-            // 调用业务处理器处理消息
-            business_handler_->handleMessage(conn_id, *msg);
-            std::cout << "[DEBUG] Business handler called successfully" << std::endl;
+            // 派发给业务处理器处理消息
+            dispatchRequest(ctx, conn_id, msg);
         } else {
             std::cerr << "[ERROR] business_handler_ is null" << std::endl;
         }
@@ -369,11 +1057,124 @@ void ConnectionHandler::processMessage(hio_t* io, std::shared_ptr<MyProtoMsg> ms
     std::cout.flush(); // 强制刷新输出
 }
 
+void ConnectionHandler::dispatchRequest(LoopContext* ctx, int conn_id, std::shared_ptr<MyProtoMsg> msg) {
+    auto it = ctx->clients.find(conn_id);
+    if (it == ctx->clients.end()) {
+        return;
+    }
+    uint64_t slot = it->second.next_request_slot++;
+    it->second.slot_sequences.push_back(msg->head.sequence);
+    
+    // 消息体未通过校验的请求不交给业务处理器，按请求顺序回复错误
+    if (!msg->error.empty()) {
+        std::shared_ptr<MyProtoMsg> response = std::make_shared<MyProtoMsg>();
+        response->head.version = msg->head.version;
+        response->head.server = msg->head.server;
+        response->head.sequence = msg->head.sequence;
+        response->head.type = MY_PROTO_TYPE_DATA;
+        response->body = json::object();
+        response->body["success"] = false;
+        response->body["message"] = msg->error;
+        onRequestCompleted(ctx, conn_id, slot, response);
+        return;
+    }
+    
+    // 没有工作线程池时在事件循环线程内直接处理
+    if (!worker_pool_) {
+        std::shared_ptr<MyProtoMsg> response = std::make_shared<MyProtoMsg>();
+        bool ok = business_handler_->handleMessage(conn_id, *msg, *response);
+        std::cout << "[DEBUG] Business handler called, result: " << (ok ? "true" : "false") << std::endl;
+        onRequestCompleted(ctx, conn_id, slot, response);
+        return;
+    }
+    
+    // 业务处理（含阻塞的数据库访问）放到工作线程，完成后把响应投递回连接所属的事件循环
+    bool submitted = worker_pool_->submit([this, ctx, conn_id, slot, msg]() {
+        std::shared_ptr<MyProtoMsg> response = std::make_shared<MyProtoMsg>();
+        bool ok = business_handler_->handleMessage(conn_id, *msg, *response);
+        std::cout << "[DEBUG] Business handler called on worker, result: " << (ok ? "true" : "false") << std::endl;
+        runInLoop(ctx->loop, [this, ctx, conn_id, slot, response]() {
+            onRequestCompleted(ctx, conn_id, slot, response);
+        });
+    });
+    if (!submitted) {
+        std::cerr << "[ERROR] Worker pool rejected request, conn_id: " << conn_id << std::endl;
+        onRequestCompleted(ctx, conn_id, slot, nullptr);
+    }
+}
+
+void ConnectionHandler::onRequestCompleted(LoopContext* ctx, int conn_id, uint64_t slot, std::shared_ptr<MyProtoMsg> response) {
+    auto it = ctx->clients.find(conn_id);
+    if (it == ctx->clients.end()) {
+        // 处理期间连接已关闭，丢弃响应
+        return;
+    }
+    
+    // 处理函数把最终响应交给了流式响应，之后以延迟响应的方式到达
+    if (response && response->deferred) {
+        return;
+    }
+    
+    ConnectionInfo& conn = it->second;
+    conn.ready_responses[slot] = response;
+    
+    // 从最早的请求开始，依次发出已经完成的响应
+    hio_t* io = conn.io;
+    while (!conn.ready_responses.empty() && conn.ready_responses.begin()->first == conn.next_response_slot) {
+        std::shared_ptr<MyProtoMsg> ready = conn.ready_responses.begin()->second;
+        conn.ready_responses.erase(conn.ready_responses.begin());
+        conn.next_response_slot++;
+        conn.slot_sequences.pop_front();
+        
+        if (ready) {
+            // 响应与请求的序列号相同，发出响应即确认了该请求，不必再单独发确认帧
+            conn.pending_acks.remove(ready->head.sequence);
+            sendResponse(io, *ready);
+        }
+        // 发送过程中连接可能已被关闭
+        if (ctx->clients.find(conn_id) == ctx->clients.end()) {
+            return;
+        }
+        
+        // 轮到的请求在等待期间产生的流式分片先于它的最终响应写出
+        auto held_it = conn.held_chunks.find(conn.next_response_slot);
+        if (held_it != conn.held_chunks.end()) {
+            std::vector<HeldChunk> held;
+            held.swap(held_it->second);
+            conn.held_chunks.erase(held_it);
+            for (size_t i = 0; i < held.size(); i++) {
+                if (!writeStreamChunk(ctx, conn_id, *held[i].chunk, held[i].on_sent)) {
+                    // 连接已断开，通知其余分片的写入方停止
+                    for (size_t j = i + 1; j < held.size(); j++) {
+                        held[j].on_sent(false);
+                    }
+                    return;
+                }
+            }
+        }
+    }
+}
+
 int ConnectionHandler::getConnectionId(hio_t* io) {
-    // 使用连接的ID作为唯一标识
+    // 使用连接的ID作为唯一标识（libhv的io id全局递增，跨事件循环不会重复）
     return hio_id(io);
 }
 
+ConnectionHandler::LoopContext* ConnectionHandler::getLoopContext(hio_t* io) {
+    hloop_t* loop = hevent_loop(io);
+    if (!loop) return nullptr;
+    return (LoopContext*)hloop_userdata(loop);
+}
+
+ConnectionHandler::LoopContext* ConnectionHandler::findLoopContext(int conn_id) {
+    std::lock_guard<std::mutex> lock(conn_loops_mutex_);
+    auto it = conn_loops_.find(conn_id);
+    if (it == conn_loops_.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
 // 发送心跳消息的回调函数
 void ConnectionHandler::sendHeartbeat(hio_t* io) {
     ConnectionHandler* handler = (ConnectionHandler*)hio_context(io);
@@ -385,36 +1186,207 @@ void ConnectionHandler::sendHeartbeat(hio_t* io) {
     MyProtoMsg heartbeat_msg;
     heartbeat_msg.head.version = 1;
     heartbeat_msg.head.server = 0; // 心跳消息不需要特定服务号
+    heartbeat_msg.head.sequence = 0; // 心跳不进入发送窗口，不分配序列号
     heartbeat_msg.head.type = MY_PROTO_TYPE_HEARTBEAT;
     heartbeat_msg.body = {"timestamp", time(nullptr)}; // 包含时间戳
     
+    // 心跳只用于探测连接，丢失时下个间隔再发，对端的心跳响应也不需要匹配序列号
     std::cout << "[DEBUG] Sending heartbeat, conn_id: " << conn_id << std::endl;
-    handler->sendMessage(io, heartbeat_msg);
+    handler->sendMessage(io, heartbeat_msg, DeliveryClass::UNRELIABLE);
+}
+
+void ConnectionHandler::refreshActivity(LoopContext* ctx, int conn_id) {
+    auto it = ctx->clients.find(conn_id);
+    if (it == ctx->clients.end()) return;
+    it->second.last_active_time = time(nullptr);
+    // 限流期间由慢消费者超时接管，同一次读回调中限流前读到的数据不再恢复空闲计时
+    if (it->second.throttled) return;
+    
+    // 有流量的连接不需要心跳，一直推迟到真正空闲一个心跳间隔之后
+    uint64_t now = hloop_now_ms(ctx->loop);
+    ctx->heartbeat_wheel.schedule(conn_id, now + heartbeat_interval_);
+    ctx->timeout_wheel.schedule(conn_id, now + heartbeat_timeout_);
 }
 
-// 心跳超时检查的回调函数
-void ConnectionHandler::onHeartbeatTimeout(htimer_t* timer) {
-    // 使用hevent_userdata API代替直接访问timer->data
+// 时间轮推进回调
+void ConnectionHandler::onWheelTick(htimer_t* timer) {
     ConnectionHandler* handler = (ConnectionHandler*)hevent_userdata((hevent_t*)timer);
     if (!handler) return;
+    LoopContext* ctx = (LoopContext*)hloop_userdata(hevent_loop(timer));
+    if (!ctx) return;
     
-    // 使用hevent_privdata API代替直接访问timer->priv_data
-    int conn_id = (int)(intptr_t)((hevent_t*)timer)->privdata;
-    auto it = handler->clients_.find(conn_id);
-    if (it == handler->clients_.end()) return;
+    uint64_t now = hloop_now_ms(ctx->loop);
+    std::vector<int> expired;
     
-    time_t current_time = time(nullptr);
-    time_t last_heartbeat = it->second.last_heartbeat_time;
-    
-    // 检查是否超时
-    if (current_time - last_heartbeat > handler->heartbeat_timeout_ / 1000) {
+    // 空闲超时的连接：超时时间在收到任意帧时刷新，能到期说明超过heartbeat_timeout_没有收到数据
+    ctx->timeout_wheel.advance(now, expired);
+    for (int conn_id : expired) {
+        auto it = ctx->clients.find(conn_id);
+        if (it == ctx->clients.end()) continue;
         std::cout << "[WARN] Heartbeat timeout, closing connection, conn_id: " << conn_id << std::endl;
         hio_close(it->second.io);
+    }
+    
+    // 限流超过slow_consumer_timeout_仍未回落到低水位的连接：断开，释放写队列和重传状态（onClose中清理）
+    expired.clear();
+    ctx->throttle_wheel.advance(now, expired);
+    for (int conn_id : expired) {
+        auto it = ctx->clients.find(conn_id);
+        if (it == ctx->clients.end() || !it->second.throttled) continue;
+        std::cout << "[WARN] Evicting slow consumer, conn_id: " << conn_id 
+                  << ", pending write bytes: " << (hio_write_bufsize(it->second.io) + it->second.output_buffer.size())
+                  << ", throttled for " << (now - it->second.throttled_since) << "ms" << std::endl;
+        ctx->evicted_clients++;
+        hio_close(it->second.io);
+    }
+    
+    // 空闲了一个心跳间隔的连接：发送心跳探测，仍无流量则下个间隔再发
+    expired.clear();
+    ctx->heartbeat_wheel.advance(now, expired);
+    for (int conn_id : expired) {
+        auto it = ctx->clients.find(conn_id);
+        if (it == ctx->clients.end()) continue;
+        ctx->heartbeat_wheel.schedule(conn_id, now + handler->heartbeat_interval_);
+        sendHeartbeat(it->second.io);
+    }
+}
+void ConnectionHandler::queueAck(LoopContext* ctx, int conn_id, const MyProtoHead& head) {
+    auto it = ctx->clients.find(conn_id);
+    if (it == ctx->clients.end()) {
+        return;
+    }
+    ConnectionInfo& conn = it->second;
+    if (ack_delay_ == 0) {
+        conn.pending_acks.add(head);
+        sendPendingAcks(ctx, conn_id);
+        return;
+    }
+    
+    if (conn.pending_acks.empty()) {
+        ctx->ack_connections.push_back(conn_id);
+    }
+    conn.pending_acks.add(head);
+    if (!ctx->ack_timer) {
+        ctx->ack_timer = htimer_add(ctx->loop, ConnectionHandler::onAckTimer, ack_delay_, 1);
+        hevent_set_userdata((hevent_t*)ctx->ack_timer, this);
+    }
+}
+
+void ConnectionHandler::sendPendingAcks(LoopContext* ctx, int conn_id) {
+    auto it = ctx->clients.find(conn_id);
+    if (it == ctx->clients.end()) {
+        return;
+    }
+    ConnectionInfo& conn = it->second;
+    MyProtoMsg ack_msg;
+    if (!conn.pending_acks.takeFrame(ack_msg)) {
+        return;
+    }
+    
+    // 与同一轮产生的其他帧合并写出
+    if (!writeMessage(ctx, conn.io, ack_msg)) {
+        std::cerr << "[ERROR] Failed to encode acknowledgment message" << std::endl;
+    }
+}
+
+void ConnectionHandler::onAckTimer(htimer_t* timer) {
+    ConnectionHandler* handler = (ConnectionHandler*)hevent_userdata((hevent_t*)timer);
+    if (!handler) return;
+    LoopContext* ctx = (LoopContext*)hloop_userdata(hevent_loop(timer));
+    if (!ctx) return;
+    
+    // 一次性定时器，回调返回后由libhv删除
+    ctx->ack_timer = nullptr;
+    std::vector<int> conn_ids;
+    conn_ids.swap(ctx->ack_connections);
+    for (int conn_id : conn_ids) {
+        handler->sendPendingAcks(ctx, conn_id);
+    }
+}
+
+bool ConnectionHandler::replayDuplicate(LoopContext* ctx, int conn_id, ConnectionInfo& conn, const MyProtoHead& head) {
+    if (dedup_max_entries_ == 0) {
+        return false;
+    }
+    
+    // 请求序列号在连接内单调递增（见MyProto.h），按低31位回绕比较
+    if (!conn.dedup_started) {
+        conn.dedup_started = true;
+        conn.dedup_high = head.sequence;
+    } else if (sequenceNotAfter(conn.dedup_high, head.sequence)) {
+        if (head.sequence != conn.dedup_high) {
+            conn.dedup_high = head.sequence;
+            trimDedupWindow(conn);
+        }
+    } else if (sequenceDistance(head.sequence, conn.dedup_high) > DEDUP_SEQUENCE_SPAN) {
+        // 大幅回退：客户端计数器重置，之前的记录不会再被重发，全部作废
+        std::cout << "Request sequence restarted, clearing dedup window, conn_id: " << conn_id
+                  << ", sequence: " << head.sequence << ", previous: " << conn.dedup_high << std::endl;
+        conn.dedup_entries.clear();
+        conn.dedup_order.clear();
+        conn.dedup_bytes = 0;
+        conn.dedup_high = head.sequence;
+    }
+    
+    auto it = conn.dedup_entries.find(head.sequence);
+    if (it == conn.dedup_entries.end()) {
+        conn.dedup_entries[head.sequence].server = head.server;
+        conn.dedup_order.push_back(head.sequence);
+        trimDedupWindow(conn);
+        return false;
+    }
+    
+    DedupEntry& entry = it->second;
+    if (entry.server != head.server) {
+        // 序列号回绕后被别的请求复用，按新请求处理，沿用原来的淘汰位置
+        conn.dedup_bytes -= entry.response.data ? entry.response.data->size() : 0;
+        entry.server = head.server;
+        entry.response = MyProtoSharedFrame();
+        return false;
+    }
+    
+    std::cout << "[DEBUG] Duplicate request, replaying, conn_id: " << conn_id
+              << ", sequence: " << head.sequence << std::endl;
+    if (entry.response.data) {
+        // 响应帧本身就是确认
+        MyProtoSharedFrame frame = entry.response;
+        writeSharedFrame(ctx, conn_id, frame, head.sequence);
     } else {
-        htimer_reset(timer, handler->heartbeat_timeout_);
+        // 还在处理或没有响应：再确认一次，让客户端停止重发
+        queueAck(ctx, conn_id, head);
+    }
+    return true;
+}
+
+void ConnectionHandler::trimDedupWindow(ConnectionInfo& conn) {
+    while (!conn.dedup_order.empty() &&
+           (conn.dedup_entries.size() > dedup_max_entries_ || conn.dedup_bytes > dedup_max_bytes_ ||
+            sequenceDistance(conn.dedup_order.front(), conn.dedup_high) >= DEDUP_SEQUENCE_SPAN)) {
+        auto it = conn.dedup_entries.find(conn.dedup_order.front());
+        conn.dedup_order.pop_front();
+        if (it != conn.dedup_entries.end()) {
+            conn.dedup_bytes -= it->second.response.data ? it->second.response.data->size() : 0;
+            conn.dedup_entries.erase(it);
+        }
     }
 }
+
+void ConnectionHandler::setDedupWindow(size_t max_entries, size_t max_bytes) {
+    dedup_max_entries_ = max_entries;
+    dedup_max_bytes_ = max_bytes;
+}
+
+void ConnectionHandler::setAckDelay(int delay_ms) {
+    ack_delay_ = delay_ms > 0 ? (uint32_t)delay_ms : 0;
+}
+
 void ConnectionHandler::setHeartbeatConfig(int interval_ms, int timeout_ms) {
     heartbeat_interval_ = interval_ms;
     heartbeat_timeout_ = timeout_ms;
+}
+
+void ConnectionHandler::setBackpressureConfig(size_t high_watermark, size_t low_watermark, int slow_consumer_timeout_ms) {
+    write_high_watermark_ = high_watermark;
+    write_low_watermark_ = low_watermark < high_watermark ? low_watermark : high_watermark / 2;
+    slow_consumer_timeout_ = slow_consumer_timeout_ms;
 }
\ No newline at end of file
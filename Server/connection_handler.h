@@ -5,42 +5,127 @@
 #include <hv/hloop.h>
 
 #include "myproto.h"
+#include "timing_wheel.h"
+#include "pending_acks.h"
+#include "reliable_msg_manager.h"
 #include <unordered_map>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <deque>
 
 // 前向声明
 class BusinessHandler;
-class ReliableMsgManager;
+class WorkerPool;
 
 // 连接处理器类，负责网络连接管理
 class ConnectionHandler {
 private:
-    hloop_t* loop_;               // libhv事件循环
+    hloop_t* loop_;               // 主事件循环（负责accept，同时也是0号工作循环）
     hio_t* server_;               // 服务器连接
-    MyProtoEncode proto_encoder_; // 协议编码器
-    MyProtoDecode proto_decoder_; // 协议解码器
+    MyProtoEncode proto_encoder_; // 协议编码器（无状态，各事件循环共用）
     BusinessHandler* business_handler_; // 业务处理器指针
-    ReliableMsgManager* reliable_msg_manager_; // 可靠消息管理器
+    WorkerPool* worker_pool_;           // 业务工作线程池，为空时在事件循环线程内直接处理
     static ConnectionHandler* instance_; // 静态实例指针
     uint32_t  heartbeat_interval_; // 心跳间隔（毫秒）
     uint32_t  heartbeat_timeout_;  // 心跳超时时间（毫秒）
+    size_t    write_high_watermark_; // 待写字节数高水位，超过后暂停读取该客户端
+    size_t    write_low_watermark_;  // 待写字节数低水位，回落到此以下恢复读取
+    uint32_t  slow_consumer_timeout_; // 持续处于高水位以上超过该时间（毫秒）则断开连接
+    uint32_t  ack_delay_;             // 延迟确认时间（毫秒），期间响应已发出则不再单独发确认帧，0为立即确认
+    size_t    dedup_max_entries_;     // 每个连接去重窗口最多记住的请求数，0为不去重
+    size_t    dedup_max_bytes_;       // 每个连接去重窗口保存的响应帧总字节数上限
     
-    // 连接信息结构体，用于存储连接的心跳相关信息
+    // 去重窗口中的一个请求：响应发出前response为空（处理中或没有响应）
+    struct DedupEntry {
+        uint16_t server;              // 请求的服务号，序列号回绕后被其他请求复用时不误判为重复
+        MyProtoSharedFrame response;  // 编码好的响应帧，重复请求到达时原样重放
+    };
+    
+    // 等待所属请求轮到回复时才写出的流式分片
+    struct HeldChunk {
+        std::shared_ptr<MyProtoMsg> chunk;
+        std::function<void(bool)> on_sent;
+    };
+    
+    // 连接信息结构体，用于存储连接的心跳相关信息和解码状态
     struct ConnectionInfo {
         hio_t* io;                 // 连接对象
-        time_t last_heartbeat_time; // 最后一次收到心跳的时间
-        htimer_t* timeout_timer;    // 超时定时器
+        time_t last_active_time;    // 最后一次收到任意帧的时间
+        std::shared_ptr<MyProtoDecode> decoder; // 本连接独享的协议解码器，半包状态不会与其他连接混在一起
+        uint64_t next_request_slot;  // 下一个派发给工作线程的请求序号
+        uint64_t next_response_slot; // 下一个应当发出的响应序号
+        // 已完成但前面还有请求未完成的响应，按请求序号排队，保证响应顺序与请求顺序一致（空指针表示该请求没有响应）。
+        // 客户端可以在一个连接上连续发送多个请求而不必等待响应，再按head.sequence匹配
+        std::map<uint64_t, std::shared_ptr<MyProtoMsg>> ready_responses;
+        std::deque<uint32_t> slot_sequences; // 已派发、尚未回复的请求的序列号，下标为请求序号减去next_response_slot
+        // 前面还有请求未回复时产生的流式分片，按请求序号暂存，轮到该请求时先于其最终响应写出
+        std::map<uint64_t, std::vector<HeldChunk>> held_chunks;
+        std::string output_buffer;   // 待写出的已编码帧，同一轮产生的多帧合并后一次写出
+        bool output_dirty;           // 是否已登记到所属循环的待写出列表
+        uint8_t codec;               // 消息体编码方式（MyProtoCodec），跟随客户端最近一次请求
+        bool accept_compression;     // 客户端能解压压缩的消息体，跟随客户端最近一次请求
+        bool throttled;              // 待写数据超过高水位，已暂停读取
+        uint64_t throttled_since;    // 开始限流的时间（毫秒，事件循环时间）
+        std::vector<std::function<void(bool)>> chunk_waiters; // 限流期间写入的流式分片回调，恢复读取或断开时通知
+        PendingAcks pending_acks;   // 已收到但还未确认的请求序列号，响应发出即视为确认，否则由延迟确认定时器合并确认
+        // 最近的可靠投递请求（写操作）按序列号记录，客户端因确认丢失重发时重放响应而不再执行
+        std::unordered_map<uint32_t, DedupEntry> dedup_entries;
+        std::deque<uint32_t> dedup_order; // 记录顺序，超出上限或过期时淘汰最早的
+        size_t dedup_bytes;               // 已保存的响应帧字节数
+        bool dedup_started;               // 是否已记录过请求
+        uint32_t dedup_high;              // 记录过的最大请求序列号，落后它太多的记录过期
+    };
+    
+    // 事件循环上下文，每个事件循环线程独享客户端表、心跳定时器和可靠消息管理器，
+    // 循环内的状态只在本线程访问，不需要加锁
+    struct LoopContext {
+        int index;                                       // 事件循环序号
+        hloop_t* loop;                                   // libhv事件循环
+        std::thread thread;                              // 事件循环线程（0号循环运行在startServer的调用线程）
+        std::atomic<std::thread::id> tid;                // 运行该循环的线程ID，由循环线程在运行前写入
+        ReliableMsgManager* reliable_msg_manager;        // 本循环的可靠消息管理器
+        std::unordered_map<int, ConnectionInfo> clients; // 本循环的客户端连接映射
+        std::string write_buffer;                        // 写出时与连接输出缓冲区交换使用，hio_write返回后即可再次使用
+        std::vector<int> dirty_connections;              // 输出缓冲区中有待写出数据的连接
+        bool in_read_callback;                           // 是否正在读回调中（读回调结束时统一写出）
+        bool flush_scheduled;                            // 是否已投递本轮结束时的写出任务
+        std::atomic<int> throttled_clients;              // 当前被限流的客户端数量
+        std::atomic<uint64_t> evicted_clients;           // 因消费过慢被断开的客户端累计数量
+        TimingWheel heartbeat_wheel;                     // 各连接空闲到需要发送心跳的时间
+        TimingWheel timeout_wheel;                       // 各连接的空闲超时时间
+        TimingWheel throttle_wheel;                      // 被限流连接的断开时间（限流期间暂停空闲超时）
+        htimer_t* wheel_timer;                           // 推进时间轮的周期定时器，每个循环只有一个
+        std::vector<int> ack_connections;                // 有待确认请求的连接
+        htimer_t* ack_timer;                             // 延迟确认定时器（一次性，有待确认请求时才存在）
     };
     
-    // 使用新的结构体来存储连接信息
-    std::unordered_map<int, ConnectionInfo> clients_;  // 客户端连接映射
+    std::vector<LoopContext*> loops_;       // 所有事件循环，loops_[0]->loop == loop_
+    std::atomic<uint32_t> next_loop_;       // 轮询分配新连接的计数器
+    std::mutex conn_loops_mutex_;           // 保护conn_loops_
+    std::unordered_map<int, LoopContext*> conn_loops_; // 连接ID到所属事件循环的映射（跨线程按ID发送时使用）
+    std::mutex state_mutex_;                // 保护loops_ready_和loops_running_
+    std::condition_variable state_cv_;      // 循环就绪、全部退出时通知
+    size_t loops_ready_;                    // 已登记线程ID、即将运行的循环数
+    bool loops_running_;                    // startServer是否正在运行各循环
     
     // 发送心跳消息的回调函数
     static void sendHeartbeat(hio_t* io);
     
-    // 心跳超时检查的回调函数
-    static void onHeartbeatTimeout(htimer_t* timer);
+    // 时间轮推进回调：批量发送到期的心跳，关闭心跳超时的连接
+    static void onWheelTick(htimer_t* timer);
+    
+    // 延迟确认定时器回调：为期间没有发出响应的请求合并发送确认帧
+    static void onAckTimer(htimer_t* timer);
 private:
-    // 连接建立回调
+    // 新连接接入回调（运行在主循环，按轮询把连接分发到各事件循环）
+    static void onAccept(hio_t* io);
+    
+    // 连接建立回调（运行在连接所属的事件循环）
     static void onConnection(hio_t* io);
     
     // 连接关闭回调
@@ -52,19 +137,90 @@ private:
     // 处理接收到的协议消息
     void processMessage(hio_t* io, std::shared_ptr<MyProtoMsg> msg);
     
+    // 派发数据消息给业务处理器，有工作线程池时在工作线程执行
+    void dispatchRequest(LoopContext* ctx, int conn_id, std::shared_ptr<MyProtoMsg> msg);
+    
+    // 编码消息并追加到连接的输出缓冲区，在读回调结束或本轮事件处理结束时合并写出
+    bool writeMessage(LoopContext* ctx, hio_t* io, MyProtoMsg& msg);
+    
+    // 以指定序列号把编码好的帧追加到连接的输出缓冲区，不重新序列化消息体（发送窗口的首次发送和重传共用）
+    bool writeSharedFrame(LoopContext* ctx, int conn_id, const MyProtoSharedFrame& frame, uint32_t sequence);
+    
+    // 按连接协商的编码方式和压缩能力设置消息头标志
+    void setMessageCodec(const ConnectionInfo& conn, MyProtoMsg& msg);
+    
+    // 输出缓冲区追加数据后的处理：数据较多时立即写出，否则登记并安排本轮结束时写出
+    bool scheduleFlush(LoopContext* ctx, int conn_id, ConnectionInfo& conn);
+    
+    // 把连接输出缓冲区中的数据一次写出
+    void flushConnection(LoopContext* ctx, int conn_id);
+    
+    // 写出本循环所有有待发送数据的连接
+    void flushPendingOutput(LoopContext* ctx);
+    
+    // 记录需要确认的请求，延迟到定时器到期时合并确认（之前发出响应则不再单独确认）
+    void queueAck(LoopContext* ctx, int conn_id, const MyProtoHead& head);
+    
+    // 发送一个确认帧，确认连接上所有待确认的请求
+    void sendPendingAcks(LoopContext* ctx, int conn_id);
+    
+    // 按序列号查去重窗口：重复的请求重放保存的响应（还没有响应时重新确认）并返回true，
+    // 新请求记入窗口后返回false
+    bool replayDuplicate(LoopContext* ctx, int conn_id, ConnectionInfo& conn, const MyProtoHead& head);
+    
+    // 淘汰最早的记录，直到条数和字节数都不超过上限，且没有落后最大序列号太多的记录
+    void trimDedupWindow(ConnectionInfo& conn);
+    
+    // 收到客户端数据后刷新活跃时间，推迟心跳发送和超时
+    void refreshActivity(LoopContext* ctx, int conn_id);
+    
+    // 检查连接的待写字节数，超过高水位时暂停读取并开始计算慢消费者超时；返回false表示连接已不存在
+    bool checkBackpressure(LoopContext* ctx, int conn_id);
+    
+    // 写完成回调，待写字节数回落到低水位以下时恢复读取
+    static void onWriteComplete(hio_t* io, const void* buf, int writebytes);
+    
+    // 在连接所属的事件循环内处理流式分片：所属请求轮到回复时立即写出，否则暂存到该请求的回复位置；
+    // 延迟的最终响应（last）填入该请求的回复位置
+    void deliverStreamChunk(LoopContext* ctx, int conn_id, MyProtoMsg& chunk, bool last, std::function<void(bool)> on_sent);
+    
+    // 写出一个流式分片，连接被限流时推迟回调；返回false表示连接已不存在
+    bool writeStreamChunk(LoopContext* ctx, int conn_id, MyProtoMsg& chunk, std::function<void(bool)> on_sent);
+    
+    // 业务处理完成（在连接所属事件循环线程内调用），按请求顺序发出响应
+    void onRequestCompleted(LoopContext* ctx, int conn_id, uint64_t slot, std::shared_ptr<MyProtoMsg> response);
+    
     // 获取连接ID
     int getConnectionId(hio_t* io);
     
-    // 重传消息回调
-    void onRetransmitMessage(int conn_id, const MyProtoMsg& msg);
+    // 获取连接所属的事件循环上下文
+    LoopContext* getLoopContext(hio_t* io);
+    
+    // 按连接ID查找所属的事件循环上下文
+    LoopContext* findLoopContext(int conn_id);
+    
+    // 关闭某个事件循环上的所有客户端连接（需在该循环线程内调用）
+    void closeClients(LoopContext* ctx);
+    
+    // 投递到事件循环的任务回调
+    static void onLoopEvent(hevent_t* ev);
+    
+    // 重传消息回调，返回是否写出
+    bool onRetransmitMessage(LoopContext* ctx, int conn_id, const PendingMessage& pending);
 public:
     ConnectionHandler();
     ~ConnectionHandler();
 
-    // 初始化连接处理器
+    // 初始化连接处理器（单事件循环）
     bool initialize(BusinessHandler* handler, ReliableMsgManager* msg_manager);
     
-    // 启动服务器
+    // 初始化连接处理器（多事件循环），每个可靠消息管理器对应一个事件循环线程
+    bool initialize(BusinessHandler* handler, const std::vector<ReliableMsgManager*>& msg_managers);
+    
+    // 设置业务工作线程池，需在startServer之前调用
+    void setWorkerPool(WorkerPool* pool) { worker_pool_ = pool; }
+    
+    // 启动服务器，阻塞运行主事件循环
     bool startServer(int port);
     
     // 停止服务器
@@ -73,22 +229,56 @@ public:
     // 连接到服务器
     hio_t* connectToServer(const char* host, int port);
     
-    // 发送消息
-    bool sendMessage(hio_t* conn, MyProtoMsg& msg);
+    // 发送消息（需在连接所属的事件循环线程内调用）
+    bool sendMessage(hio_t* conn, MyProtoMsg& msg, DeliveryClass delivery = DeliveryClass::RELIABLE);
     
-    // 发送消息(使用连接ID)
-    bool sendMessage(int conn_id, MyProtoMsg& msg);
+    // 发送消息(使用连接ID)，可在任意线程调用，非所属线程时投递到所属事件循环发送
+    bool sendMessage(int conn_id, MyProtoMsg& msg, DeliveryClass delivery = DeliveryClass::RELIABLE);
     
-    // 广播消息给所有客户端
-    void broadcastMessage(MyProtoMsg& msg);
+    // 发送业务响应，序列号保持为请求的序列号（需在连接所属的事件循环线程内调用）
+    bool sendResponse(hio_t* conn, MyProtoMsg& response);
+    
+    // 发送业务响应(使用连接ID)，可在任意线程调用
+    bool sendResponse(int conn_id, MyProtoMsg& response);
+    
+    // 发送流式响应分片(使用连接ID)，可在任意线程调用，分片内容会被移走；分片与响应一样按请求顺序写出，
+    // 所属请求前面还有请求未回复时暂存，轮到该请求时才写出；
+    // 分片写入连接后回调on_sent(true)，连接被限流时等到恢复后才回调，连接断开时回调on_sent(false)；
+    // last为true时该帧是处理函数返回时标记为延迟的最终响应，作为该请求的响应按序发出，不回调on_sent
+    bool sendStreamChunk(int conn_id, MyProtoMsg& chunk, bool last, std::function<void(bool)> on_sent);
+    
+    // 广播消息给所有客户端，每个事件循环在自己的线程内发送。消息被复制，调用方的消息不会被修改；
+    // 每种编码方式（及是否压缩）在第一次有连接需要时才序列化，且只序列化一次
+    void broadcastMessage(const MyProtoMsg& msg);
+    
+    // 投递任务到指定事件循环线程执行（线程安全）
+    static void runInLoop(hloop_t* loop, std::function<void()> task);
     
     // 获取事件循环
     hloop_t* getEventLoop() { return loop_; }
+    
+    // 获取事件循环数量
+    int getEventLoopCount() const { return (int)loops_.size(); }
     static ConnectionHandler* getInstance() { return instance_; }
     static void setInstance(ConnectionHandler* instance) { instance_ = instance; }
     
     // 设置心跳参数
     void setHeartbeatConfig(int interval_ms, int timeout_ms);
+    
+    // 设置发送背压参数：高低水位（字节）和慢消费者断开时间（毫秒）
+    void setBackpressureConfig(size_t high_watermark, size_t low_watermark, int slow_consumer_timeout_ms);
+    
+    // 设置延迟确认时间（毫秒），0表示收到请求立即确认
+    void setAckDelay(int delay_ms);
+    
+    // 设置每个连接请求去重窗口的条数和响应字节数上限，条数为0时不去重
+    void setDedupWindow(size_t max_entries, size_t max_bytes);
+    
+    // 当前被限流（暂停读取）的客户端数量
+    int getThrottledClientCount() const;
+    
+    // 因消费过慢被断开的客户端累计数量
+    uint64_t getEvictedClientCount() const;
 };
 
 #endif // __CONNECTION_HANDLER_H__
\ No newline at end of file
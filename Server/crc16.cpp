@@ -0,0 +1,157 @@
+#include "crc16.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CRC16_HAVE_CLMUL 1
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CRC16_TARGET_CLMUL
+#else
+#define CRC16_TARGET_CLMUL __attribute__((target("pclmul,ssse3")))
+#endif
+#endif
+
+namespace {
+
+const uint16_t POLYNOMIAL = 0x1021;
+
+// slice-by-8查表：table[k][b]是字节b后面再跟k个0字节时对CRC的贡献
+struct CrcTables {
+    uint16_t table[8][256];
+};
+
+constexpr CrcTables makeTables() {
+    CrcTables t{};
+    for (int i = 0; i < 256; i++) {
+        uint16_t crc = (uint16_t)(i << 8);
+        for (int j = 0; j < 8; j++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ POLYNOMIAL) : (uint16_t)(crc << 1);
+        }
+        t.table[0][i] = crc;
+    }
+    for (int k = 1; k < 8; k++) {
+        for (int i = 0; i < 256; i++) {
+            uint16_t prev = t.table[k - 1][i];
+            t.table[k][i] = (uint16_t)((prev << 8) ^ t.table[0][prev >> 8]);
+        }
+    }
+    return t;
+}
+
+constexpr CrcTables TABLES = makeTables();
+
+uint16_t updateTable(uint16_t crc, const uint8_t* data, size_t length) {
+    const uint16_t (*t)[256] = TABLES.table;
+    while (length >= 8) {
+        crc = t[7][data[0] ^ (crc >> 8)] ^ t[6][data[1] ^ (crc & 0xFF)] ^
+              t[5][data[2]] ^ t[4][data[3]] ^ t[3][data[4]] ^
+              t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+        data += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = (uint16_t)((crc << 8) ^ t[0][(crc >> 8) ^ *data++]);
+    }
+    return crc;
+}
+
+#ifdef CRC16_HAVE_CLMUL
+// 低于该长度时折叠的准备和收尾开销不划算，直接查表
+const size_t CLMUL_MIN_LENGTH = 64;
+
+// 折叠系数x^192、x^128模多项式的余数，只算一次（每次调用都算的话短数据上比查表还慢）
+const uint16_t FOLD_X192 = shiftCRC(24);
+const uint16_t FOLD_X128 = shiftCRC(16);
+
+// 把每16字节看作一个128位多项式（首字节为最高位），累加值A与下一块B折叠为
+// A*x^128 + B，其中A的高、低64位分别乘以x^192、x^128模多项式的余数，结果不超过80位。
+// 折叠结果与原数据模多项式同余，最后把累加值的16字节交给查表实现即可得到CRC
+CRC16_TARGET_CLMUL
+uint16_t updateClmul(uint16_t crc, const uint8_t* data, size_t length) {
+    const __m128i reverse = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m128i k = _mm_set_epi64x(FOLD_X192, FOLD_X128); // 高64位: x^192, 低64位: x^128
+
+    // 初值等价于异或到数据的前16位上
+    __m128i acc = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), reverse);
+    acc = _mm_xor_si128(acc, _mm_set_epi64x((long long)((uint64_t)crc << 48), 0));
+    data += 16;
+    length -= 16;
+
+    while (length >= 16) {
+        __m128i block = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), reverse);
+        __m128i hi = _mm_clmulepi64_si128(acc, k, 0x11);
+        __m128i lo = _mm_clmulepi64_si128(acc, k, 0x00);
+        acc = _mm_xor_si128(_mm_xor_si128(hi, lo), block);
+        data += 16;
+        length -= 16;
+    }
+
+    uint8_t folded[16];
+    _mm_storeu_si128((__m128i*)folded, _mm_shuffle_epi8(acc, reverse));
+    crc = updateTable(0, folded, sizeof(folded));
+    return updateTable(crc, data, length);
+}
+
+bool detectClmul() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 1)) && (info[2] & (1 << 9)); // PCLMULQDQ、SSSE3
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+#endif
+}
+
+const bool USE_CLMUL = detectClmul();
+#endif
+
+} // namespace
+
+uint16_t updateCRC(uint16_t crc, const uint8_t* data, size_t length) {
+#ifdef CRC16_HAVE_CLMUL
+    if (USE_CLMUL && length >= CLMUL_MIN_LENGTH) {
+        return updateClmul(crc, data, length);
+    }
+#endif
+    return updateTable(crc, data, length);
+}
+
+uint16_t updateCRCTable(uint16_t crc, const uint8_t* data, size_t length) {
+    return updateTable(crc, data, length);
+}
+
+uint16_t multiplyCRC(uint16_t a, uint16_t b) {
+    uint16_t result = 0;
+    for (int i = 15; i >= 0; i--) {
+        result = (result & 0x8000) ? (uint16_t)((result << 1) ^ POLYNOMIAL) : (uint16_t)(result << 1);
+        if ((b >> i) & 1) {
+            result ^= a;
+        }
+    }
+    return result;
+}
+
+uint16_t shiftCRC(size_t n) {
+    uint16_t result = 1;
+    uint16_t base = 0x0100; // x^8
+    while (n) {
+        if (n & 1) {
+            result = multiplyCRC(result, base);
+        }
+        base = multiplyCRC(base, base);
+        n >>= 1;
+    }
+    return result;
+}
+
+const char* crcImplementation() {
+#ifdef CRC16_HAVE_CLMUL
+    if (USE_CLMUL) {
+        return "pclmulqdq";
+    }
+#endif
+    return "slice-by-8";
+}
@@ -0,0 +1,27 @@
+#ifndef __CRC16_H__
+#define __CRC16_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC-16/CCITT-FALSE（多项式0x1021，初值0xFFFF，不反射，无结果异或）
+// 默认使用slice-by-8查表，每次处理8字节；x86-64上CPU支持PCLMULQDQ时，
+// 大块数据改用无进位乘法折叠，实现在运行时检测一次后选定
+
+// 以crc为初值继续计算data的CRC，可分段调用：updateCRC(updateCRC(c, a), b) == 对a、b拼接后计算
+uint16_t updateCRC(uint16_t crc, const uint8_t* data, size_t length);
+
+// 同上，但总是用slice-by-8查表，供测试和基准测试与PCLMULQDQ实现对照
+uint16_t updateCRCTable(uint16_t crc, const uint8_t* data, size_t length);
+
+// 模多项式的乘法。CRC对数据是线性的：从状态s出发处理n字节的结果，
+// 等于multiplyCRC(s, shiftCRC(n))再异或上从0出发处理同样数据的结果
+uint16_t multiplyCRC(uint16_t a, uint16_t b);
+
+// x^(8n) mod 多项式，即CRC状态经过n个字节后的变换系数
+uint16_t shiftCRC(size_t n);
+
+// 当前使用的实现名称，用于启动日志
+const char* crcImplementation();
+
+#endif // __CRC16_H__
@@ -0,0 +1,48 @@
+#include "pending_acks.h"
+#include <algorithm>
+
+void PendingAcks::add(const MyProtoHead& head) {
+    version_ = head.version;
+    server_ = head.server;
+    sequences_.push_back(head.sequence);
+}
+
+bool PendingAcks::remove(uint32_t sequence) {
+    auto it = std::find(sequences_.begin(), sequences_.end(), sequence);
+    if (it == sequences_.end()) {
+        return false;
+    }
+    sequences_.erase(it);
+    return true;
+}
+
+bool PendingAcks::takeFrame(MyProtoMsg& ack_msg) {
+    if (sequences_.empty()) {
+        return false;
+    }
+    // 重发的请求可能让同一序列号排队了多次
+    std::sort(sequences_.begin(), sequences_.end());
+    sequences_.erase(std::unique(sequences_.begin(), sequences_.end()), sequences_.end());
+
+    ack_msg.head.version = version_;
+    ack_msg.head.server = server_;
+    ack_msg.head.sequence = sequences_.back();
+    ack_msg.head.type = MY_PROTO_TYPE_ACK;
+    ack_msg.body = nlohmann::json::object();
+    if (sequences_.size() > 1) {
+        nlohmann::json ranges = nlohmann::json::array();
+        uint32_t first = sequences_[0];
+        uint32_t last = sequences_[0];
+        for (size_t i = 1; i < sequences_.size(); ++i) {
+            if (sequences_[i] != last + 1) {
+                ranges.push_back({ first, last });
+                first = sequences_[i];
+            }
+            last = sequences_[i];
+        }
+        ranges.push_back({ first, last });
+        ack_msg.body["sack"] = std::move(ranges);
+    }
+    sequences_.clear();
+    return true;
+}
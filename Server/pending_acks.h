@@ -0,0 +1,33 @@
+#ifndef __PENDING_ACKS_H__
+#define __PENDING_ACKS_H__
+
+#include <stdint.h>
+#include <vector>
+#include "MyProto.h"
+
+// 一个连接上已收到、还未确认的请求序列号。响应发出即确认了对应请求（从这里移除），
+// 剩下的在延迟确认定时器到期时合并为一个确认帧：消息头序列号为其中最大的一个，
+// 多于一个时消息体中用sack列出全部确认的区间；只确认一个请求的确认帧与原来的格式相同。
+class PendingAcks {
+private:
+    std::vector<uint32_t> sequences_;
+    uint8_t version_;   // 确认帧使用的协议版本和服务号，跟随最近一次请求
+    uint16_t server_;
+
+public:
+    PendingAcks() : version_(1), server_(0) {}
+
+    // 记录一个待确认的请求
+    void add(const MyProtoHead& head);
+
+    // 响应捎带确认了sequence，返回它是否在待确认中
+    bool remove(uint32_t sequence);
+
+    // 把全部待确认的请求合并为一个确认帧并清空；没有待确认的请求时返回false
+    bool takeFrame(MyProtoMsg& ack_msg);
+
+    bool empty() const { return sequences_.empty(); }
+    size_t size() const { return sequences_.size(); }
+};
+
+#endif // __PENDING_ACKS_H__
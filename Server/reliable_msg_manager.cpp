@@ -1,9 +1,38 @@
 #include "reliable_msg_manager.h"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 时间轮使用的毫秒时间
+uint64_t steadyMs(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+// 环形数组的初始容量，大多数连接同时未确认的消息很少
+const size_t RING_INITIAL_CAPACITY = 8;
+
+} // namespace
+
+// 各服务的投递类别，启动时注册，之后只读
+static DeliveryClass serviceDeliveries[65536] = { DeliveryClass::RELIABLE };
+
+void registerServiceDelivery(uint16_t server, DeliveryClass delivery) {
+    serviceDeliveries[server] = delivery;
+}
+
+DeliveryClass serviceDelivery(uint16_t server) {
+    return serviceDeliveries[server];
+}
 
 ReliableMsgManager::ReliableMsgManager(int max_retransmits, int retransmit_interval)
     : max_retransmits_(max_retransmits), retransmit_interval_(retransmit_interval),
-      loop_(nullptr), timeout_timer_(nullptr), retransmit_callback_(nullptr) {
+      min_rto_(200), max_rto_(60000), check_interval_(100),
+      window_messages_(64), window_bytes_(1024 * 1024), max_queued_(256),
+      max_queued_bytes_(4 * 1024 * 1024),
+      loop_(nullptr), timeout_timer_(nullptr), retransmit_callback_(nullptr),
+      rng_(std::random_device()()) {
 }
 
 ReliableMsgManager::~ReliableMsgManager() {
@@ -18,26 +47,87 @@ void ReliableMsgManager::setRetransmitCallback(RetransmitCallback callback) {
     retransmit_callback_ = callback;
 }
 
-uint32_t ReliableMsgManager::generateSequence(int conn_id) {
-    // 为每个连接维护独立的序列号
-    auto& conn = connections_[conn_id];
-    uint32_t sequence = conn.next_sequence;
-    conn.next_sequence++;
-    return sequence;
+void ReliableMsgManager::setTransmitCallback(TransmitCallback callback) {
+    transmit_callback_ = callback;
 }
 
-void ReliableMsgManager::savePendingMessage(int conn_id, const MyProtoMsg& msg) {
+void ReliableMsgManager::setRtoConfig(int min_rto, int max_rto) {
+    min_rto_ = min_rto > 0 ? min_rto : 1;
+    max_rto_ = std::max(max_rto, min_rto_);
+    check_interval_ = std::max(min_rto_ / 2, 10);
+    // 一格为一个检测间隔，1024格覆盖的时间远大于常见的重传超时
+    retransmit_wheel_ = TimingWheel(check_interval_, 1024);
+}
+
+void ReliableMsgManager::setWindowConfig(size_t window_messages, size_t window_bytes, size_t max_queued,
+                                         size_t max_queued_bytes) {
+    window_messages_ = window_messages > 0 ? window_messages : 1;
+    window_bytes_ = window_bytes;
+    max_queued_ = max_queued;
+    max_queued_bytes_ = max_queued_bytes;
+}
+
+bool ReliableMsgManager::sendReliable(int conn_id, const MyProtoSharedFrame& frame, uint32_t* sequence_out) {
+    if (!frame.data) {
+        return false;
+    }
+    
     auto& conn = connections_[conn_id];
-    PendingMessage pending_msg;
-    pending_msg.msg = msg;
-    pending_msg.status = MessageStatus::PENDING_ACK;
-    pending_msg.retransmit_count = 0;
-    pending_msg.send_time = std::chrono::steady_clock::now();
     
-    conn.pending_messages[msg.head.sequence] = pending_msg;
+    if (conn.slots.empty()) {
+        conn.rto_ms = std::min(std::max(retransmit_interval_, min_rto_), max_rto_);
+    }
+    size_t used = sequenceDistance(conn.base_sequence, conn.next_sequence);
+    // 排队的字节数也有上限，大帧在条数远未排满时就可能占用大量内存
+    // （队列为空时总能放入一条，与在途字节数的规则一致，避免大消息永远发不出去）
+    size_t bytes = frame.data->size();
+    if (used >= window_messages_ + max_queued_ ||
+        (conn.queued_bytes > 0 && conn.queued_bytes + bytes > max_queued_bytes_)) {
+        std::cerr << "Send queue full, drop message, conn_id: " << conn_id 
+                  << ", in flight: " << conn.in_flight << ", queued bytes: " << conn.queued_bytes << std::endl;
+        return false;
+    }
+    // 环形数组从小容量开始，放不下时翻倍，最多到不小于窗口加排队上限的2的幂
+    if (used >= conn.slots.size()) {
+        growRing(conn);
+    }
+    
+    uint32_t sequence = conn.next_sequence;
+    conn.next_sequence = (conn.next_sequence + 1) | SERVER_SEQUENCE_BASE; // 回绕时保持在服务器序列号空间内
+    if (sequence_out) {
+        *sequence_out = sequence;
+    }
     
-    std::cout << "Saved pending message, conn_id: " << conn_id 
-              << ", sequence: " << msg.head.sequence << std::endl;
+    size_t index = sequence & (conn.slots.size() - 1);
+    PendingMessage& pending_msg = conn.slots[index];
+    pending_msg.frame = frame;
+    pending_msg.sequence = sequence;
+    pending_msg.status = MessageStatus::QUEUED;
+    pending_msg.retransmit_count = 0;
+    pending_msg.bytes = bytes;
+    conn.occupied[index] = true;
+    conn.queued_bytes += bytes;
+    
+    advanceWindow(conn_id);
+    return true;
+}
+
+void ReliableMsgManager::growRing(ConnectionStatus& conn) {
+    size_t capacity = conn.slots.empty() ? RING_INITIAL_CAPACITY : conn.slots.size() * 2;
+    std::vector<PendingMessage> slots(capacity);
+    std::vector<bool> occupied(capacity, false);
+    // 占用的序列号都在[base_sequence, next_sequence)内，跨度小于旧容量，新容量下不会冲突
+    size_t old_mask = conn.slots.size() - 1;
+    for (uint32_t seq = conn.base_sequence; !conn.slots.empty() && seq != conn.next_sequence;
+         seq = (seq + 1) | SERVER_SEQUENCE_BASE) {
+        if (conn.occupied[seq & old_mask]) {
+            size_t index = seq & (capacity - 1);
+            slots[index] = std::move(conn.slots[seq & old_mask]);
+            occupied[index] = true;
+        }
+    }
+    conn.slots.swap(slots);
+    conn.occupied.swap(occupied);
 }
 
 void ReliableMsgManager::processConfirmation(int conn_id, uint32_t sequence) {
@@ -46,20 +136,176 @@ void ReliableMsgManager::processConfirmation(int conn_id, uint32_t sequence) {
         return;
     }
     
-    auto& pending_messages = it_conn->second.pending_messages;
-    auto it_msg = pending_messages.find(sequence);
-    if (it_msg != pending_messages.end()) {
-        it_msg->second.status = MessageStatus::ACKED;
-        std::cout << "Message confirmed, conn_id: " << conn_id 
-                  << ", sequence: " << sequence << std::endl;
+    if (confirmSlot(it_conn->second, sequence, std::chrono::steady_clock::now())) {
+        advanceWindow(conn_id);
+    }
+}
+
+void ReliableMsgManager::processCumulativeConfirmation(int conn_id, uint32_t up_to) {
+    processRangeConfirmation(conn_id, up_to - 0x3FFFFFFF, up_to);
+}
+
+void ReliableMsgManager::processRangeConfirmation(int conn_id, uint32_t first, uint32_t last) {
+    auto it_conn = connections_.find(conn_id);
+    if (it_conn == connections_.end()) {
+        return;
+    }
+    
+    // 只需要看已发出的部分，区间与[base_sequence, send_sequence)取交集。
+    // 客户端可能发来超出窗口的区间（错误或恶意的SACK），不能按区间长度遍历
+    ConnectionStatus& conn = it_conn->second;
+    if (conn.base_sequence == conn.send_sequence) {
+        return;
+    }
+    first |= SERVER_SEQUENCE_BASE;
+    last |= SERVER_SEQUENCE_BASE;
+    uint32_t sent_last = (conn.send_sequence - 1) | SERVER_SEQUENCE_BASE;
+    if (!sequenceNotAfter(first, sent_last) || !sequenceNotAfter(conn.base_sequence, last)) {
+        return; // 区间整体在已发出部分之后或之前
+    }
+    uint32_t begin = sequenceNotAfter(conn.base_sequence, first) ? first : conn.base_sequence;
+    uint32_t end = sequenceNotAfter(last, sent_last) ? last : sent_last;
+    if (!sequenceNotAfter(begin, end)) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    size_t confirmed = 0;
+    for (uint32_t seq = begin; ; seq = (seq + 1) | SERVER_SEQUENCE_BASE) {
+        if (confirmSlot(conn, seq, now)) {
+            ++confirmed;
+        }
+        if (seq == end) {
+            break;
+        }
+    }
+    if (confirmed > 0) {
+        advanceWindow(conn_id);
+    }
+}
+
+size_t ReliableMsgManager::inFlightCount(int conn_id) const {
+    auto it_conn = connections_.find(conn_id);
+    return it_conn == connections_.end() ? 0 : it_conn->second.in_flight;
+}
+
+size_t ReliableMsgManager::queuedCount(int conn_id) const {
+    auto it_conn = connections_.find(conn_id);
+    if (it_conn == connections_.end()) {
+        return 0;
+    }
+    return sequenceDistance(it_conn->second.send_sequence, it_conn->second.next_sequence);
+}
+
+bool ReliableMsgManager::releaseSlot(ConnectionStatus& conn, uint32_t sequence) {
+    // 只有窗口内已发出的消息可以确认，排队中的和更早已释放的序列号忽略
+    if (conn.slots.empty() ||
+        sequenceDistance(conn.base_sequence, sequence) >= sequenceDistance(conn.base_sequence, conn.send_sequence)) {
+        return false;
+    }
+    size_t index = sequence & (conn.slots.size() - 1);
+    if (!conn.occupied[index]) {
+        return false;
+    }
+    PendingMessage& pending_msg = conn.slots[index];
+    conn.in_flight--;
+    conn.in_flight_bytes -= pending_msg.bytes;
+    conn.occupied[index] = false;
+    // 释放帧的引用（广播帧在最后一个连接确认后释放），槽位本身留给后面的序列号复用
+    pending_msg.status = MessageStatus::ACKED;
+    pending_msg.frame.data.reset();
+    return true;
+}
+
+bool ReliableMsgManager::confirmSlot(ConnectionStatus& conn, uint32_t sequence,
+                                     std::chrono::steady_clock::time_point now) {
+    if (!releaseSlot(conn, sequence)) {
+        return false;
+    }
+    // releaseSlot只释放帧字节，发送时间和重传次数仍在槽位中。
+    // Karn算法：重传过的消息无法区分确认对应哪一次发送，不作为RTT样本
+    const PendingMessage& pending_msg = conn.slots[sequence & (conn.slots.size() - 1)];
+    if (pending_msg.retransmit_count == 0) {
+        updateRtt(conn, std::chrono::duration<double, std::milli>(now - pending_msg.send_time).count());
+    }
+    return true;
+}
+
+void ReliableMsgManager::updateRtt(ConnectionStatus& conn, double sample_ms) {
+    if (!conn.has_rtt_sample) {
+        conn.has_rtt_sample = true;
+        conn.srtt_ms = sample_ms;
+        conn.rttvar_ms = sample_ms / 2;
+    } else {
+        conn.rttvar_ms = 0.75 * conn.rttvar_ms + 0.25 * std::fabs(conn.srtt_ms - sample_ms);
+        conn.srtt_ms = 0.875 * conn.srtt_ms + 0.125 * sample_ms;
+    }
+    // 偏差项至少为一个检测间隔，超时检测的粒度本身就有这么大的误差
+    double rto = conn.srtt_ms + std::max(4 * conn.rttvar_ms, (double)check_interval_);
+    conn.rto_ms = (int)std::min(std::max(rto, (double)min_rto_), (double)max_rto_);
+}
+
+void ReliableMsgManager::armRetransmit(int conn_id, ConnectionStatus& conn, PendingMessage& pending,
+                                       std::chrono::steady_clock::time_point from) {
+    // 每重传一次超时翻倍，拥塞的客户端不会按固定节奏被反复重传
+    long long rto = (long long)conn.rto_ms << std::min(pending.retransmit_count, 16);
+    rto = std::min(rto, (long long)max_rto_);
+    // 加上0~25%的随机抖动，网络抖动导致大量连接同时超时时重传被打散到不同的检测周期
+    rto += rng_() % (rto / 4 + 1);
+    pending.deadline = from + std::chrono::milliseconds(rto);
+    scheduleCheck(conn_id, conn, steadyMs(pending.deadline));
+}
+
+void ReliableMsgManager::scheduleCheck(int conn_id, ConnectionStatus& conn, uint64_t deadline_ms) {
+    // 每个连接在时间轮中只登记最早的截止时间；消息确认后不撤销，到期时检查一遍再登记下一个
+    if (conn.check_deadline_ms == 0 || deadline_ms < conn.check_deadline_ms) {
+        conn.check_deadline_ms = deadline_ms;
+        retransmit_wheel_.schedule(conn_id, deadline_ms);
+    }
+}
+
+void ReliableMsgManager::advanceWindow(int conn_id) {
+    auto it_conn = connections_.find(conn_id);
+    if (it_conn == connections_.end()) {
+        return;
+    }
+    ConnectionStatus* conn = &it_conn->second;
+    size_t mask = conn->slots.size() - 1;
+    
+    // 窗口起点越过已确认的消息
+    while (conn->base_sequence != conn->send_sequence && !conn->occupied[conn->base_sequence & mask]) {
+        conn->base_sequence = (conn->base_sequence + 1) | SERVER_SEQUENCE_BASE;
+    }
+    
+    // 窗口打开时按序发出排队的消息（字节数允许最后一条超出上限，避免大消息永远发不出去）
+    while (conn->send_sequence != conn->next_sequence &&
+           sequenceDistance(conn->base_sequence, conn->send_sequence) < window_messages_ &&
+           conn->in_flight_bytes < window_bytes_) {
+        uint32_t sequence = conn->send_sequence;
+        PendingMessage& pending_msg = conn->slots[sequence & mask];
+        conn->send_sequence = (sequence + 1) | SERVER_SEQUENCE_BASE;
+        conn->in_flight++;
+        conn->in_flight_bytes += pending_msg.bytes;
+        conn->queued_bytes -= pending_msg.bytes;
+        pending_msg.status = MessageStatus::PENDING_ACK;
+        pending_msg.send_time = std::chrono::steady_clock::now();
+        armRetransmit(conn_id, *conn, pending_msg, pending_msg.send_time);
         
-        // 移除已确认的消息
-        pending_messages.erase(it_msg);
+        if (transmit_callback_) {
+            transmit_callback_(conn_id, pending_msg);
+        }
+        
+        // 写出时连接可能因背压被关闭，连接状态随之移除
+        it_conn = connections_.find(conn_id);
+        if (it_conn == connections_.end()) {
+            return;
+        }
+        conn = &it_conn->second;
     }
 }
 
 void ReliableMsgManager::removeConnection(int conn_id) {
     connections_.erase(conn_id);
+    retransmit_wheel_.cancel(conn_id);
     std::cout << "Connection removed, conn_id: " << conn_id << std::endl;
 }
 
@@ -70,7 +316,7 @@ void ReliableMsgManager::startTimeoutCheck() {
     }
     
     if (!timeout_timer_) {
-        timeout_timer_ = htimer_add(loop_, timeoutCallback, retransmit_interval_, retransmit_interval_);
+        timeout_timer_ = htimer_add(loop_, timeoutCallback, check_interval_, INFINITE);
         if (timeout_timer_) {
             hevent_set_userdata(timeout_timer_, this);
             std::cout << "Timeout check started" << std::endl;
@@ -87,36 +333,62 @@ void ReliableMsgManager::stopTimeoutCheck() {
 }
 
 void ReliableMsgManager::checkTimeouts() {
-    auto now = std::chrono::steady_clock::now();
+    uint64_t now_ms = steadyMs(std::chrono::steady_clock::now());
     
-    for (auto& conn_pair : connections_) {
-        int conn_id = conn_pair.first;
-        auto& pending_messages = conn_pair.second.pending_messages;
-        
-        // 使用迭代器安全删除
-        for (auto it = pending_messages.begin(); it != pending_messages.end();) {
-            auto& pending_msg = it->second;
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - pending_msg.send_time).count();
-            
-            if (pending_msg.status == MessageStatus::PENDING_ACK && elapsed > retransmit_interval_) {
-                if (pending_msg.retransmit_count < max_retransmits_) {
-                    // 执行重传操作
-                    retransmitMessage(conn_id, it->first);
-                    ++it; // 继续下一个消息
-                } else {
-                    // 超过最大重传次数
-                    std::cout << "Message max retransmits reached, conn_id: " << conn_id 
-                              << ", sequence: " << it->first << std::endl;
-                    pending_msg.status = MessageStatus::TIMEOUT;
-                    
-                    // 删除超时消息
-                    it = pending_messages.erase(it);
-                }
+    // 只取出最早截止时间已到的连接，其余连接和消息本轮不访问
+    std::vector<int> expired;
+    retransmit_wheel_.advance(now_ms, expired);
+    
+    // 先收集到期的消息再处理：重传写出时连接可能被关闭，遍历中不能修改connections_
+    std::vector<std::pair<int, uint32_t>> due;
+    for (int conn_id : expired) {
+        auto it_conn = connections_.find(conn_id);
+        if (it_conn == connections_.end()) {
+            continue;
+        }
+        ConnectionStatus& conn = it_conn->second;
+        conn.check_deadline_ms = 0;
+        size_t mask = conn.slots.size() - 1;
+        // 窗口内已发出的消息最多window_messages_条，未到期的重新登记最早的截止时间
+        for (uint32_t seq = conn.base_sequence; seq != conn.send_sequence; seq = (seq + 1) | SERVER_SEQUENCE_BASE) {
+            if (!conn.occupied[seq & mask]) {
+                continue;
+            }
+            PendingMessage& pending_msg = conn.slots[seq & mask];
+            if (pending_msg.status != MessageStatus::PENDING_ACK) {
+                continue;
+            }
+            uint64_t deadline_ms = steadyMs(pending_msg.deadline);
+            if (deadline_ms <= now_ms) {
+                due.push_back(std::make_pair(conn_id, seq));
             } else {
-                ++it; // 继续下一个消息
+                scheduleCheck(conn_id, conn, deadline_ms);
             }
         }
     }
+    
+    for (const auto& item : due) {
+        auto it_conn = connections_.find(item.first);
+        if (it_conn == connections_.end()) {
+            continue;
+        }
+        ConnectionStatus& conn = it_conn->second;
+        size_t index = item.second & (conn.slots.size() - 1);
+        if (!conn.occupied[index]) {
+            continue;
+        }
+        if (conn.slots[index].retransmit_count < max_retransmits_) {
+            // 执行重传操作
+            retransmitMessage(item.first, item.second);
+        } else {
+            // 超过最大重传次数，放弃该消息并释放窗口
+            std::cout << "Message max retransmits reached, conn_id: " << item.first 
+                      << ", sequence: " << item.second << std::endl;
+            conn.slots[index].status = MessageStatus::TIMEOUT;
+            releaseSlot(conn, item.second);
+            advanceWindow(item.first);
+        }
+    }
 }
 
 void ReliableMsgManager::retransmitMessage(int conn_id, uint32_t sequence) {
@@ -125,28 +397,31 @@ void ReliableMsgManager::retransmitMessage(int conn_id, uint32_t sequence) {
         return;
     }
     
-    auto& pending_messages = it_conn->second.pending_messages;
-    auto it_msg = pending_messages.find(sequence);
-    if (it_msg != pending_messages.end()) {
-        PendingMessage& pending_msg = it_msg->second;
-        
-        // 更新消息状态和重传计数
-        pending_msg.status = MessageStatus::RETRANSMITTED;
+    ConnectionStatus& conn = it_conn->second;
+    size_t index = sequence & (conn.slots.size() - 1);
+    if (!conn.occupied[index]) {
+        return;
+    }
+    
+    // 调用回调函数进行实际重传，沿用原序列号；回调中连接可能被关闭
+    bool written = !retransmit_callback_ || retransmit_callback_(conn_id, conn.slots[index]);
+    it_conn = connections_.find(conn_id);
+    if (it_conn == connections_.end() || !it_conn->second.occupied[index] ||
+        it_conn->second.slots[index].sequence != sequence) {
+        return;
+    }
+    
+    PendingMessage& pending_msg = it_conn->second.slots[index];
+    auto now = std::chrono::steady_clock::now();
+    pending_msg.status = MessageStatus::PENDING_ACK;
+    if (written) {
+        // 真正写出才计入重传次数并退避
         pending_msg.retransmit_count++;
-        pending_msg.send_time = std::chrono::steady_clock::now();
-        
-        std::cout << "Retransmitting message, conn_id: " << conn_id 
-                  << ", sequence: " << sequence 
-                  << ", retransmit_count: " << pending_msg.retransmit_count << std::endl;
-        
-        // 调用回调函数进行实际重传
-        if (retransmit_callback_) {
-            retransmit_callback_(conn_id, pending_msg.msg);
-        }
-        
-        // 重传后状态变回等待确认
-        pending_msg.status = MessageStatus::PENDING_ACK;
+        pending_msg.send_time = now;
     }
+    // 没写出（客户端被限流）时不消耗重传次数，按当前的退避间隔稍后再试；
+    // 限流持续过久的连接由连接处理器按慢消费者断开。send_time不变，原发送仍可作为RTT样本
+    armRetransmit(conn_id, it_conn->second, pending_msg, now);
 }
 
 void ReliableMsgManager::timeoutCallback(htimer_t* timer) {
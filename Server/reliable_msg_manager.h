@@ -2,46 +2,105 @@
 #define __RELIABLE_MSG_MANAGER_H__
 
 #include <map>
+#include <vector>
 #include <chrono>
 #include <memory>
 #include <functional>
+#include <random>
 #include "myproto.h"
+#include "timing_wheel.h"
 #include <hv/hloop.h>
 
+// 服务器主动发送消息的序列号从该值开始（最高位为1），
+// 与客户端请求的序列号（业务响应沿用）分开，避免客户端确认响应时误确认服务器消息
+const uint32_t SERVER_SEQUENCE_BASE = 0x80000000;
+
+// 服务器序列号在低31位上回绕，a在b之前或相等（按回绕比较，两者相差不超过半个序列号空间）
+inline bool sequenceNotAfter(uint32_t a, uint32_t b) {
+    return ((b - a) & 0x7FFFFFFF) < 0x40000000;
+}
+
+// 两个服务器序列号之间的距离（b - a，按低31位回绕）
+inline uint32_t sequenceDistance(uint32_t a, uint32_t b) {
+    return (b - a) & 0x7FFFFFFF;
+}
+
+// 投递类别：只有可靠消息进入发送窗口，占用序列号、重传定时和内存
+enum class DeliveryClass : uint8_t {
+    RELIABLE = 0,   // 写操作和服务器推送：推送分配服务器序列号，等待确认，超时重传
+    AT_MOST_ONCE,   // 幂等读请求的响应：只发一次，请求不单独确认，丢失时客户端重新请求
+    UNRELIABLE      // 心跳、心跳响应和确认：直接写出，不跟踪
+};
+
+// 注册服务的投递类别（未注册的为RELIABLE），需在开始收消息前调用，之后只读
+void registerServiceDelivery(uint16_t server, DeliveryClass delivery);
+DeliveryClass serviceDelivery(uint16_t server);
+
 // 消息状态枚举
 enum class MessageStatus {
+    QUEUED,        // 发送窗口已满，排队等待发送
     PENDING_ACK,   // 等待确认
     ACKED,         // 已确认
     TIMEOUT,       // 超时
     RETRANSMITTED  // 已重传
 };
 
-// 待确认消息结构体
+// 待确认消息结构体：只保存编码好的帧，不保留json消息体。
+// 帧字节引用计数共享（广播时多个连接共享同一份），首次发送和重传都写出同样的字节
 struct PendingMessage {
-    MyProtoMsg msg;                      // 消息内容
+    MyProtoSharedFrame frame;            // 编码好的整帧，写出时填入序列号
+    uint32_t sequence;                   // 分配的序列号，重传沿用
     MessageStatus status;                // 消息状态
     int retransmit_count;                // 重传次数
-    std::chrono::steady_clock::time_point send_time;  // 发送时间
+    size_t bytes;                        // 帧长度，发出后计入窗口的在途字节数
+    std::chrono::steady_clock::time_point send_time;  // 最近一次发送时间
+    std::chrono::steady_clock::time_point deadline;   // 重传截止时间
 };
 
-// 连接状态结构体
+// 连接状态结构体：发送窗口。序列号[base_sequence, send_sequence)为已发出的消息（其中已确认的留空），
+// [send_sequence, next_sequence)为排队等待窗口打开的消息，都按序列号存放在环形数组中
 struct ConnectionStatus {
-    uint32_t next_sequence;              // 下一个要发送的序列号
-    std::map<uint32_t, PendingMessage> pending_messages;  // 待确认消息
+    uint32_t next_sequence = SERVER_SEQUENCE_BASE; // 下一个要分配的序列号
+    uint32_t base_sequence = SERVER_SEQUENCE_BASE; // 最早的未确认序列号，窗口起点
+    uint32_t send_sequence = SERVER_SEQUENCE_BASE; // 下一个要发出的序列号
+    std::vector<PendingMessage> slots;             // 环形数组，下标为序列号 & (容量 - 1)，容量为2的幂，按需翻倍
+    std::vector<bool> occupied;                    // 对应槽位是否有消息
+    size_t in_flight = 0;                          // 已发出未确认的消息数
+    size_t in_flight_bytes = 0;                    // 已发出未确认的字节数
+    size_t queued_bytes = 0;                       // 排队等待窗口打开的字节数
+    // RTT估计（RFC 6298），由确认到达的时间计算
+    bool has_rtt_sample = false;                   // 是否已有RTT样本
+    double srtt_ms = 0;                            // 平滑RTT
+    double rttvar_ms = 0;                          // RTT偏差
+    int rto_ms = 0;                                // 当前重传超时，有样本前为初始值
+    uint64_t check_deadline_ms = 0;                // 在时间轮中登记的最早重传截止时间，0为未登记
 };
 
-// 重传回调函数类型
-typedef std::function<void(int conn_id, const MyProtoMsg& msg)> RetransmitCallback;
+// 重传回调函数类型：以原序列号重新写出同一帧，返回是否写出（客户端被限流时跳过）
+typedef std::function<bool(int conn_id, const PendingMessage& pending)> RetransmitCallback;
+
+// 发送回调函数类型：窗口允许时把帧写到连接上
+typedef std::function<void(int conn_id, const PendingMessage& pending)> TransmitCallback;
 
 // 可靠消息管理器类
 class ReliableMsgManager {
 private:
     std::map<int, ConnectionStatus> connections_;  // 连接ID到连接状态的映射
+    TimingWheel retransmit_wheel_;                // 按连接登记最早的重传截止时间，检测时只处理到期的连接
     int max_retransmits_;                         // 最大重传次数
-    int retransmit_interval_;                     // 重传间隔（毫秒）
+    int retransmit_interval_;                     // 初始重传超时（毫秒），连接还没有RTT样本时使用
+    int min_rto_;                                 // 重传超时下限（毫秒）
+    int max_rto_;                                 // 重传超时上限（毫秒），退避后也不超过
+    int check_interval_;                          // 超时检测间隔（毫秒）
+    size_t window_messages_;                      // 每个连接最多在途的消息数
+    size_t window_bytes_;                         // 每个连接最多在途的字节数
+    size_t max_queued_;                           // 每个连接窗口外最多排队的消息数
+    size_t max_queued_bytes_;                     // 每个连接窗口外最多排队的字节数
     hloop_t* loop_;                               // 事件循环指针
     htimer_t* timeout_timer_;                     // 超时检测定时器
     RetransmitCallback retransmit_callback_;      // 重传回调函数
+    TransmitCallback transmit_callback_;          // 发送回调函数
+    std::minstd_rand rng_;                        // 重传超时抖动
 
 public:
     ReliableMsgManager(int max_retransmits = 3, int retransmit_interval = 1000);
@@ -49,37 +108,76 @@ public:
 
     // 设置事件循环
     void setEventLoop(hloop_t* loop);
-    
+
     // 设置重传回调函数
     void setRetransmitCallback(RetransmitCallback callback);
-    
-    // 生成序列号
-    uint32_t generateSequence(int conn_id);
-    
-    // 保存待发送消息
-    void savePendingMessage(int conn_id, const MyProtoMsg& msg);
-    
+
+    // 设置发送回调函数
+    void setTransmitCallback(TransmitCallback callback);
+
+    // 设置重传超时的上下限，需在启动超时检测前调用（检测间隔取下限的一半）
+    void setRtoConfig(int min_rto, int max_rto);
+
+    // 设置发送窗口：在途消息数、在途字节数上限和窗口外排队的消息数、字节数上限，需在建立连接前调用
+    void setWindowConfig(size_t window_messages, size_t window_bytes, size_t max_queued, size_t max_queued_bytes);
+
+    // 可靠发送：分配序列号（sequence_out不为空时写回）并把编码好的帧放入发送窗口，
+    // 窗口未满时立即通过发送回调写出，否则排队等确认到来后再发。排队的条数或字节数已满返回false
+    bool sendReliable(int conn_id, const MyProtoSharedFrame& frame, uint32_t* sequence_out = nullptr);
+
     // 处理消息确认
     void processConfirmation(int conn_id, uint32_t sequence);
-    
+
+    // 累计确认：序列号不超过up_to的待确认消息全部确认
+    void processCumulativeConfirmation(int conn_id, uint32_t up_to);
+
+    // 选择确认：确认[first, last]区间内的待确认消息
+    void processRangeConfirmation(int conn_id, uint32_t first, uint32_t last);
+
+    // 连接的在途消息数和排队消息数
+    size_t inFlightCount(int conn_id) const;
+    size_t queuedCount(int conn_id) const;
+
     // 移除连接
     void removeConnection(int conn_id);
-    
+
     // 启动超时检测
     void startTimeoutCheck();
-    
+
     // 停止超时检测
     void stopTimeoutCheck();
 
 private:
     // 检查超时消息
     void checkTimeouts();
-    
+
     // 重传消息
     void retransmitMessage(int conn_id, uint32_t sequence);
-    
+
+    // 环形数组容量翻倍（首次分配为初始容量），未确认和排队的消息按新容量重新放置
+    void growRing(ConnectionStatus& conn);
+
+    // 释放一个已发出的槽位（确认或放弃重传），返回是否释放了
+    bool releaseSlot(ConnectionStatus& conn, uint32_t sequence);
+
+    // 确认一条消息：释放槽位，未重传过的消息（Karn算法）用作RTT样本
+    bool confirmSlot(ConnectionStatus& conn, uint32_t sequence, std::chrono::steady_clock::time_point now);
+
+    // 用一个RTT样本更新平滑RTT、偏差和重传超时
+    void updateRtt(ConnectionStatus& conn, double sample_ms);
+
+    // 从from开始按连接的重传超时、消息的重传次数（指数退避）和随机抖动计算重传截止时间，并登记到时间轮
+    void armRetransmit(int conn_id, ConnectionStatus& conn, PendingMessage& pending,
+                       std::chrono::steady_clock::time_point from);
+
+    // 截止时间早于连接已登记的时间时重新登记
+    void scheduleCheck(int conn_id, ConnectionStatus& conn, uint64_t deadline_ms);
+
+    // 窗口起点越过已释放的槽位，再发出窗口内排队的消息
+    void advanceWindow(int conn_id);
+
     // 定时器回调函数
     static void timeoutCallback(htimer_t* timer);
 };
 
-#endif // __RELIABLE_MSG_MANAGER_H__
\ No newline at end of file
+#endif // __RELIABLE_MSG_MANAGER_H__
@@ -0,0 +1,321 @@
+#include "request_schema.h"
+#include "MyProto.h"
+#include <unordered_map>
+
+using json = nlohmann::json;
+typedef nlohmann::detail::json_sax_dom_parser<json> DomBuilder;
+
+namespace {
+
+// 键名允许的字符：字母、数字和下划线，查表代替逐个find_first_not_of
+struct KeyCharset {
+    bool allowed[256];
+    KeyCharset() {
+        for (int c = 0; c < 256; ++c) {
+            allowed[c] = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        }
+    }
+};
+const KeyCharset keyCharset;
+
+bool isValidKey(const std::string& key) {
+    if (key.size() > REQUEST_SCHEMA_MAX_STRING) {
+        return false;
+    }
+    for (unsigned char c : key) {
+        if (!keyCharset.allowed[c]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::unordered_map<uint16_t, RequestSchema>& schemaRegistry() {
+    static std::unordered_map<uint16_t, RequestSchema> registry;
+    return registry;
+}
+
+typedef nlohmann::json_sax<json> Sax;
+
+// 把SAX事件转给DOM构建器（json_sax_dom_parser不是json_sax的子类）
+class DomSink : public Sax {
+public:
+    explicit DomSink(json& result) : dom_(result, false) {}
+
+    bool null() override { return dom_.null(); }
+    bool boolean(bool val) override { return dom_.boolean(val); }
+    bool number_integer(number_integer_t val) override { return dom_.number_integer(val); }
+    bool number_unsigned(number_unsigned_t val) override { return dom_.number_unsigned(val); }
+    bool number_float(number_float_t val, const string_t& s) override { return dom_.number_float(val, s); }
+    bool string(string_t& val) override { return dom_.string(val); }
+    bool start_object(std::size_t len) override { return dom_.start_object(len); }
+    bool key(string_t& val) override { return dom_.key(val); }
+    bool end_object() override { return dom_.end_object(); }
+    bool start_array(std::size_t len) override { return dom_.start_array(len); }
+    bool end_array() override { return dom_.end_array(); }
+    bool parse_error(std::size_t position, const std::string& last_token, const nlohmann::detail::exception& ex) override {
+        return dom_.parse_error(position, last_token, ex);
+    }
+
+private:
+    DomBuilder dom_;
+};
+
+// 校验用的SAX处理器：通用规则作用于所有层级，模式只约束data对象的直接成员。
+// sink不为空时校验通过的事件转发给它（构建DOM或直接写入类型化请求）
+class RequestValidator : public Sax {
+public:
+    // rootIsData为true时根对象本身就是data（版本1中字符串形式的data），dataSink接收该字符串解析出的事件
+    RequestValidator(const RequestSchema* schema, Sax* sink, Sax* dataSink, bool rootIsData)
+        : schema_(schema), sink_(sink), dataSink_(dataSink), rootIsData_(rootIsData) {}
+
+    const std::string& error() const { return error_; }
+
+    // 整个消息体解析完后检查必填字段
+    bool finish() {
+        if (schema_ && (seen_ & schema_->requiredMask()) != schema_->requiredMask()) {
+            return fail("Missing required field: " + schema_->missingField(seen_));
+        }
+        return true;
+    }
+
+    bool null() override {
+        return value(SCHEMA_ANY) && (!sink_ || sink_->null());
+    }
+
+    bool boolean(bool val) override {
+        return value(SCHEMA_BOOLEAN) && (!sink_ || sink_->boolean(val));
+    }
+
+    bool number_integer(number_integer_t val) override {
+        return value(SCHEMA_INTEGER) && (!sink_ || sink_->number_integer(val));
+    }
+
+    bool number_unsigned(number_unsigned_t val) override {
+        return value(SCHEMA_INTEGER) && (!sink_ || sink_->number_unsigned(val));
+    }
+
+    bool number_float(number_float_t val, const string_t& s) override {
+        return value(SCHEMA_NUMBER) && (!sink_ || sink_->number_float(val, s));
+    }
+
+    bool string(string_t& val) override {
+        if (!value(SCHEMA_STRING)) {
+            return false;
+        }
+        if (!rootIsData_ && depth_ == 1 && key_ == "data") {
+            // 版本1的data是JSON字符串，按同一模式再校验一遍，字符串本身不受通用长度限制
+            RequestValidator nested(schema_, dataSink_, nullptr, true);
+            if (!json::sax_parse(nlohmann::detail::input_adapter(val.data(), val.size()), &nested) || !nested.finish()) {
+                return fail(nested.error().empty() ? "Invalid request data" : nested.error());
+            }
+            seen_ |= nested.seen_;
+        }
+        else {
+            size_t limit = field_ >= 0 ? schema_->field(field_).maxSize : REQUEST_SCHEMA_MAX_STRING;
+            if (val.size() > limit) {
+                return fail("String value too long for key: " + key_);
+            }
+        }
+        return !sink_ || sink_->string(val);
+    }
+
+    bool start_object(std::size_t len) override {
+        if (!value(SCHEMA_OBJECT, true)) {
+            return false;
+        }
+        if (depth_ == 0 && rootIsData_) {
+            dataDepth_ = 1;
+        }
+        else if (!rootIsData_ && depth_ == 1 && key_ == "data" && dataDepth_ == 0) {
+            dataDepth_ = 2;
+        }
+        ++depth_;
+        return !sink_ || sink_->start_object(len);
+    }
+
+    bool key(string_t& val) override {
+        if (!isValidKey(val)) {
+            return fail("Invalid character in JSON key: " + val);
+        }
+        key_ = val;
+        return !sink_ || sink_->key(val);
+    }
+
+    bool end_object() override {
+        if (depth_ == dataDepth_) {
+            dataDepth_ = -1; // data只取第一次出现的对象
+        }
+        --depth_;
+        return !sink_ || sink_->end_object();
+    }
+
+    bool start_array(std::size_t len) override {
+        if (!value(SCHEMA_ARRAY)) {
+            return false;
+        }
+        ++depth_;
+        if (field_ >= 0 && arrayDepth_ == 0) {
+            // 模式中声明的数组，统计直接元素个数
+            arrayDepth_ = depth_;
+            arrayField_ = field_;
+            arrayCount_ = 0;
+        }
+        return !sink_ || sink_->start_array(len);
+    }
+
+    bool end_array() override {
+        if (depth_ == arrayDepth_) {
+            arrayDepth_ = 0;
+        }
+        --depth_;
+        return !sink_ || sink_->end_array();
+    }
+
+    bool parse_error(std::size_t position, const std::string& last_token, const nlohmann::detail::exception& ex) override {
+        if (sink_) {
+            sink_->parse_error(position, last_token, ex);
+        }
+        return fail(std::string("Request body parse error at ") + std::to_string(position) + ": " + ex.what());
+    }
+
+private:
+    const RequestSchema* schema_;
+    Sax* sink_;            // 接收校验通过事件的处理器
+    Sax* dataSink_;       // 接收版本1字符串data事件的处理器
+    bool rootIsData_;
+    int depth_ = 0;       // 当前所在容器的嵌套深度
+    int dataDepth_ = 0;   // data对象成员所在的深度，0为还未遇到，-1为已结束
+    int field_ = -1;      // 当前值对应的模式字段下标
+    uint64_t seen_ = 0;   // 已出现的模式字段
+    int arrayDepth_ = 0;  // 正在计数的数组元素所在深度
+    int arrayField_ = -1;
+    size_t arrayCount_ = 0;
+    std::string key_;     // 最近的键名，即下一个值所属的字段
+    std::string error_;
+
+    bool fail(const std::string& message) {
+        error_ = message;
+        return false;
+    }
+
+    // 每个值（包括容器开始）先经过这里：检查根类型、数组元素数和模式字段类型
+    bool value(SchemaFieldType type, bool isObject = false) {
+        field_ = -1;
+        if (depth_ == 0) {
+            return isObject || fail("Request body must be an object");
+        }
+        if (depth_ == arrayDepth_) {
+            const RequestSchema::Field& array = schema_->field(arrayField_);
+            if (++arrayCount_ > array.maxSize) {
+                return fail("Too many elements in field: " + array.name);
+            }
+        }
+        if (!schema_ || depth_ != dataDepth_) {
+            return true;
+        }
+        field_ = schema_->find(key_);
+        if (field_ < 0) {
+            return true;
+        }
+        SchemaFieldType expected = schema_->field(field_).type;
+        bool match = expected == SCHEMA_ANY || expected == type ||
+                     (expected == SCHEMA_NUMBER && type == SCHEMA_INTEGER);
+        if (!match) {
+            return fail("Wrong type for field: " + key_);
+        }
+        seen_ |= uint64_t(1) << field_;
+        return true;
+    }
+};
+
+} // namespace
+
+RequestSchema& RequestSchema::add(const char* name, SchemaFieldType type, bool required, size_t maxSize) {
+    if (fields_.size() >= MAX_FIELDS) {
+        throw std::length_error("RequestSchema supports at most 64 fields");
+    }
+    if (required) {
+        requiredMask_ |= uint64_t(1) << fields_.size();
+    }
+    fields_.push_back(Field{ name, type, required, maxSize });
+    return *this;
+}
+
+int RequestSchema::find(const std::string& key) const {
+    for (size_t i = 0; i < fields_.size(); ++i) {
+        if (fields_[i].name == key) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+const std::string& RequestSchema::missingField(uint64_t seenMask) const {
+    static const std::string none;
+    for (size_t i = 0; i < fields_.size(); ++i) {
+        if (fields_[i].required && !(seenMask & (uint64_t(1) << i))) {
+            return fields_[i].name;
+        }
+    }
+    return none;
+}
+
+void registerRequestSchema(uint16_t server, const RequestSchema& schema) {
+    schemaRegistry()[server] = schema;
+}
+
+const RequestSchema* findRequestSchema(uint16_t server) {
+    const std::unordered_map<uint16_t, RequestSchema>& registry = schemaRegistry();
+    auto it = registry.find(server);
+    return it == registry.end() ? nullptr : &it->second;
+}
+
+nlohmann::detail::input_format_t bodyInputFormat(uint8_t flags) {
+    switch (flags & MY_PROTO_CODEC_MASK) {
+    case MY_PROTO_CODEC_MSGPACK:
+        return nlohmann::detail::input_format_t::msgpack;
+    case MY_PROTO_CODEC_CBOR:
+        return nlohmann::detail::input_format_t::cbor;
+    default:
+        return nlohmann::detail::input_format_t::json;
+    }
+}
+
+bool validateRequestBody(const uint8_t* data, size_t len, uint8_t flags,
+                         const RequestSchema* schema, json* out, std::string& error) {
+    if (len == 0) {
+        if (out) {
+            *out = json::object();
+        }
+        return validateRequestBody(data, len, flags, schema, nullptr, nullptr, error);
+    }
+
+    json result;
+    DomSink dom(result);
+    if (!validateRequestBody(data, len, flags, schema, out ? &dom : nullptr, nullptr, error)) {
+        return false;
+    }
+    if (out) {
+        *out = std::move(result);
+    }
+    return true;
+}
+
+bool validateRequestBody(const uint8_t* data, size_t len, uint8_t flags, const RequestSchema* schema,
+                         Sax* sink, Sax* dataSink, std::string& error) {
+    RequestValidator validator(schema, sink, dataSink, false);
+    if (len == 0) {
+        if (!validator.finish()) {
+            error = validator.error();
+            return false;
+        }
+        return true;
+    }
+    if (!json::sax_parse(nlohmann::detail::input_adapter(data, len), &validator, bodyInputFormat(flags)) ||
+        !validator.finish()) {
+        error = validator.error().empty() ? "Invalid request body" : validator.error();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,79 @@
+#ifndef __REQUEST_SCHEMA_H__
+#define __REQUEST_SCHEMA_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "json.hpp"
+
+// 按服务号注册的请求模式：声明data对象中各字段的类型、是否必填和大小上限。
+// 解码器在解析消息体的同一遍SAX中完成校验（需要DOM时同时构建），
+// 不合法的请求在进入业务处理和数据库访问之前就被拒绝（按请求的序列号回复错误）。
+
+// 没有声明大小上限的字符串和键名的最大长度
+const size_t REQUEST_SCHEMA_MAX_STRING = 1024;
+
+enum SchemaFieldType {
+    SCHEMA_ANY = 0,
+    SCHEMA_STRING,
+    SCHEMA_INTEGER,
+    SCHEMA_NUMBER,   // 整数或浮点数
+    SCHEMA_BOOLEAN,
+    SCHEMA_OBJECT,
+    SCHEMA_ARRAY
+};
+
+class RequestSchema {
+public:
+    struct Field {
+        std::string name;
+        SchemaFieldType type;
+        bool required;
+        size_t maxSize;  // 字符串为最大长度，数组为最大元素数，其他类型忽略
+    };
+
+    // 最多64个字段，必填字段用位图检查
+    static const size_t MAX_FIELDS = 64;
+
+    RequestSchema& required(const char* name, SchemaFieldType type, size_t maxSize = REQUEST_SCHEMA_MAX_STRING) {
+        return add(name, type, true, maxSize);
+    }
+    RequestSchema& optional(const char* name, SchemaFieldType type, size_t maxSize = REQUEST_SCHEMA_MAX_STRING) {
+        return add(name, type, false, maxSize);
+    }
+
+    // 按键名查找字段下标，未声明的字段返回-1（不校验类型，只检查通用规则）
+    int find(const std::string& key) const;
+
+    const Field& field(int index) const { return fields_[index]; }
+    uint64_t requiredMask() const { return requiredMask_; }
+    // 第一个未出现的必填字段名
+    const std::string& missingField(uint64_t seenMask) const;
+
+private:
+    std::vector<Field> fields_;
+    uint64_t requiredMask_ = 0;
+
+    RequestSchema& add(const char* name, SchemaFieldType type, bool required, size_t maxSize);
+};
+
+// 注册服务号的请求模式，需在开始收消息前调用，之后只读
+void registerRequestSchema(uint16_t server, const RequestSchema& schema);
+// 未注册的服务返回nullptr，只应用通用规则（键名字符集和字符串长度）
+const RequestSchema* findRequestSchema(uint16_t server);
+
+// 消息头编码标志对应的nlohmann输入格式
+nlohmann::detail::input_format_t bodyInputFormat(uint8_t flags);
+
+// 单遍解析并校验消息体：schema为空时只检查通用规则；out不为空时同时构建DOM。
+// 空消息体视为空对象（ACK、心跳等），有必填字段的模式下仍会失败
+bool validateRequestBody(const uint8_t* data, size_t len, uint8_t flags,
+                         const RequestSchema* schema, nlohmann::json* out, std::string& error);
+
+// 同上，校验通过的SAX事件转发给sink（如类型化请求的绑定器），sink返回false时解析停止。
+// 版本1中以字符串形式存放的data按同一模式再校验一遍，其事件转发给dataSink（为空时不转发）
+bool validateRequestBody(const uint8_t* data, size_t len, uint8_t flags, const RequestSchema* schema,
+                         nlohmann::json_sax<nlohmann::json>* sink, nlohmann::json_sax<nlohmann::json>* dataSink,
+                         std::string& error);
+
+#endif // __REQUEST_SCHEMA_H__
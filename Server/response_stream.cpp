@@ -0,0 +1,161 @@
+#include "response_stream.h"
+#include <algorithm>
+
+// 同时在途的分片数上限
+static const int MAX_IN_FLIGHT_CHUNKS = 4;
+
+// 每个分片的行数上限：行数由客户端指定，不限制时一个分片（以及一批查询）可以大到整个结果集
+static const size_t MAX_ROWS_PER_CHUNK = 1000;
+
+std::shared_ptr<ResponseStream> ResponseStream::create(BusinessHandler* handler, int conn_id, const MyProtoMsg& request,
+                                                       BodyFiller filler, RowSource source, size_t rows_per_chunk) {
+    return std::shared_ptr<ResponseStream>(new ResponseStream(handler, conn_id, request, filler, source, rows_per_chunk));
+}
+
+ResponseStream::ResponseStream(BusinessHandler* handler, int conn_id, const MyProtoMsg& request,
+                               BodyFiller filler, RowSource source, size_t rows_per_chunk)
+    : handler_(handler), conn_id_(conn_id), head_(request.head), filler_(filler), source_(source),
+      rows_per_chunk_(std::min(std::max(rows_per_chunk, (size_t)1), MAX_ROWS_PER_CHUNK)), rows_(nlohmann::json::array()),
+      row_count_(0), chunk_count_(0), in_flight_(0), reading_(false), closed_(false), finished_(false) {
+    head_.type = MY_PROTO_TYPE_DATA;
+    head_.flags = 0;
+}
+
+void ResponseStream::start(MyProtoMsg& response) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reading_ = true;
+    }
+    readBatch(&response);
+}
+
+void ResponseStream::readBatch(MyProtoMsg* response) {
+    // 只读满在途分片的空位，上一批总是读满整数个分片，当前分片此时为空
+    size_t limit;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        limit = (MAX_IN_FLIGHT_CHUNKS - in_flight_) * rows_per_chunk_;
+    }
+
+    size_t count = 0;
+    std::string message;
+    bool ok = source_(limit, [this, &count](nlohmann::json& row) {
+        count++;
+        row_count_++;
+        rows_.push_back(std::move(row));
+        if (rows_.size() >= rows_per_chunk_) {
+            flush();
+        }
+    }, message);
+
+    if (ok && count >= limit) {
+        // 还有行没读完，等分片写出后从游标处继续
+        if (response) {
+            response->deferred = true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            reading_ = false;
+        }
+        resume();
+        return;
+    }
+
+    // 结果集读完或出错：发出剩余的行，再发出结束标记
+    if (ok && !rows_.empty()) {
+        ok = flush();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+    }
+    if (response) {
+        fillEnd(*response, ok, message);
+        return;
+    }
+    MyProtoMsg end;
+    end.head = head_;
+    fillEnd(end, ok, message);
+    handler_->sendDeferredResponse(conn_id_, end);
+}
+
+void ResponseStream::resume() {
+    {
+        // 在途分片回落到一半以下才读取下一批，每次查询至少读满两个分片
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (reading_ || closed_ || finished_ || in_flight_ > MAX_IN_FLIGHT_CHUNKS / 2) {
+            return;
+        }
+        reading_ = true;
+    }
+
+    std::shared_ptr<ResponseStream> self = shared_from_this();
+    if (!handler_->submitTask([self]() { self->readBatch(nullptr); })) {
+        // 线程池已停止，以失败结束，该请求之后的响应不会一直等待它的最终响应
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            finished_ = true;
+        }
+        MyProtoMsg end;
+        end.head = head_;
+        fillEnd(end, false, "服务器繁忙，流式响应中断");
+        handler_->sendDeferredResponse(conn_id_, end);
+    }
+}
+
+bool ResponseStream::flush() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            rows_ = nlohmann::json::array();
+            return false;
+        }
+        in_flight_++;
+    }
+
+    nlohmann::json result;
+    result["success"] = true;
+    result["stream"] = true;
+    result["chunk"] = chunk_count_++;
+    result["rows"] = std::move(rows_);
+    rows_ = nlohmann::json::array();
+
+    MyProtoMsg chunk;
+    chunk.head = head_;
+    filler_(result, chunk);
+
+    // 分片写入连接后回调（连接被限流时要等到恢复读取），空出位置后继续读取
+    std::shared_ptr<ResponseStream> self = shared_from_this();
+    bool posted = handler_->sendChunk(conn_id_, chunk, [self](bool ok) {
+        {
+            std::lock_guard<std::mutex> lock(self->mutex_);
+            self->in_flight_--;
+            if (!ok) {
+                self->closed_ = true;
+            }
+        }
+        if (ok) {
+            self->resume();
+        }
+    });
+    if (!posted) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_--;
+        closed_ = true;
+        return false;
+    }
+    return true;
+}
+
+void ResponseStream::fillEnd(MyProtoMsg& frame, bool success, const std::string& message) {
+    nlohmann::json result;
+    result["success"] = success;
+    result["stream"] = true;
+    result["end"] = true;
+    result["chunks"] = chunk_count_;
+    result["total"] = row_count_;
+    if (!message.empty()) {
+        result["message"] = message;
+    }
+    filler_(result, frame);
+}
@@ -0,0 +1,65 @@
+#ifndef __RESPONSE_STREAM_H__
+#define __RESPONSE_STREAM_H__
+
+#include <mutex>
+#include <memory>
+#include <functional>
+#include "business_handler.h"
+
+// 流式响应：大结果集按分片逐帧发送，每帧带若干行，最后以结束标记作为请求的最终响应。
+// 分片与请求使用相同的序列号，客户端按序列号把分片归到同一个请求；分片和结束标记都按请求顺序写出。
+// 行由数据源分批读取，每批只读满在途分片数的上限，游标保存在数据源中；分片写出后由写出回调把下一批
+// 提交到业务工作线程池。客户端读得慢（连接被限流）时分片迟迟不回调，也就不再读取，
+// 不会有工作线程阻塞等待，内存占用与结果集大小无关。
+class ResponseStream : public std::enable_shared_from_this<ResponseStream> {
+public:
+    // 把分片或结束标记的结果填入消息体，与处理函数填充普通响应的方式一致
+    typedef std::function<void(const nlohmann::json& result, MyProtoMsg& frame)> BodyFiller;
+
+    // 从游标之后读取至多limit行交给on_row（row可以被移走）并推进游标；出错时返回false，message为原因
+    typedef std::function<bool(size_t limit, const std::function<void(nlohmann::json& row)>& on_row,
+                               std::string& message)> RowSource;
+
+    // 每个分片的行数限制在1到1000之间
+    static std::shared_ptr<ResponseStream> create(BusinessHandler* handler, int conn_id, const MyProtoMsg& request,
+                                                  BodyFiller filler, RowSource source, size_t rows_per_chunk = 200);
+
+    // 在处理函数中调用，读取第一批行。结果集在第一批内读完时把结束标记填入response；
+    // 否则把response标记为延迟，后续批次在工作线程池中读取，结束标记随最后一个分片发出
+    void start(MyProtoMsg& response);
+
+private:
+    ResponseStream(BusinessHandler* handler, int conn_id, const MyProtoMsg& request,
+                   BodyFiller filler, RowSource source, size_t rows_per_chunk);
+
+    // 读取一批行并发出攒满的分片，结果集读完或出错时发出结束标记（start中填入response）
+    void readBatch(MyProtoMsg* response);
+
+    // 分片写出后调用：在途分片回落到一半以下且没有正在读取的批次时，提交下一批读取
+    void resume();
+
+    // 把当前分片交给连接处理器，连接已断开时返回false
+    bool flush();
+
+    // 填充结束标记
+    void fillEnd(MyProtoMsg& frame, bool success, const std::string& message);
+
+    BusinessHandler* handler_;
+    int conn_id_;
+    MyProtoHead head_;            // 分片的消息头，沿用请求的版本、服务号和序列号
+    BodyFiller filler_;
+    RowSource source_;
+    size_t rows_per_chunk_;
+    // 以下读取状态同一时刻只有一个批次访问（reading_保证）
+    nlohmann::json rows_;         // 当前分片中的行
+    size_t row_count_;
+    int chunk_count_;
+    // 分片回调与读取批次共享的流控状态
+    std::mutex mutex_;
+    int in_flight_;               // 已交给连接处理器、尚未写入连接的分片数
+    bool reading_;                // 有批次正在读取或已提交到线程池
+    bool closed_;                 // 连接已断开
+    bool finished_;               // 结束标记已发出
+};
+
+#endif // __RESPONSE_STREAM_H__
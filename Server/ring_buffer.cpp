@@ -0,0 +1,117 @@
+#include "ring_buffer.h"
+#include <cstring>
+#include <algorithm>
+
+// 扩容后连续这么多次读取前缓存的数据都不到容量的1/4，才在读空时缩回初始容量
+static const size_t SHRINK_IDLE_CONSUMES = 16;
+
+RingBuffer::RingBuffer(size_t initial_capacity) : read_pos_(0), size_(0), idle_consumes_(0) {
+    size_t capacity = 1;
+    while (capacity < initial_capacity) {
+        capacity <<= 1;
+    }
+    buffer_.resize(capacity);
+    initial_capacity_ = capacity;
+}
+
+void RingBuffer::reallocate(size_t capacity) {
+    // 按顺序把旧数据拷贝到新缓冲区开头
+    std::vector<uint8_t> new_buffer(capacity);
+    size_t first = std::min(size_, buffer_.size() - read_pos_);
+    memcpy(new_buffer.data(), buffer_.data() + read_pos_, first);
+    memcpy(new_buffer.data() + first, buffer_.data(), size_ - first);
+
+    buffer_.swap(new_buffer);
+    read_pos_ = 0;
+}
+
+void RingBuffer::grow(size_t min_capacity) {
+    size_t capacity = buffer_.size();
+    while (capacity < min_capacity) {
+        capacity <<= 1;
+    }
+    reallocate(capacity);
+    idle_consumes_ = 0;
+}
+
+void RingBuffer::shrinkIfIdle(size_t held) {
+    if (buffer_.size() <= initial_capacity_) {
+        return;
+    }
+    // 只看一次读取后的剩余量会在大帧之间缩容，下一个大帧又要扩容
+    if (held >= buffer_.size() / 4) {
+        idle_consumes_ = 0;
+        return;
+    }
+    if (++idle_consumes_ >= SHRINK_IDLE_CONSUMES && size_ == 0) {
+        reallocate(initial_capacity_);
+        idle_consumes_ = 0;
+    }
+}
+
+void RingBuffer::linearize() {
+    if (read_pos_ == 0) {
+        return;
+    }
+    // 旋转整个缓冲区，使读位置落到开头
+    std::rotate(buffer_.begin(), buffer_.begin() + read_pos_, buffer_.end());
+    read_pos_ = 0;
+}
+
+void RingBuffer::append(const void* data, size_t len) {
+    if (len == 0) {
+        return;
+    }
+    if (size_ + len > buffer_.size()) {
+        grow(size_ + len);
+    }
+
+    // 写位置之后到缓冲区末尾的空间不够时分两段拷贝
+    size_t mask = buffer_.size() - 1;
+    size_t write_pos = (read_pos_ + size_) & mask;
+    size_t first = std::min(len, buffer_.size() - write_pos);
+    memcpy(buffer_.data() + write_pos, data, first);
+    memcpy(buffer_.data(), (const uint8_t*)data + first, len - first);
+    size_ += len;
+}
+
+const uint8_t* RingBuffer::peek(size_t len) {
+    if (len > size_) {
+        return nullptr;
+    }
+    // 跨越末尾的数据才需要整理，每写满一圈最多整理一次
+    if (read_pos_ + len > buffer_.size()) {
+        linearize();
+    }
+    return buffer_.data() + read_pos_;
+}
+
+const uint8_t* RingBuffer::segment(size_t offset, size_t& len) const {
+    if (offset >= size_) {
+        len = 0;
+        return nullptr;
+    }
+    size_t pos = (read_pos_ + offset) & (buffer_.size() - 1);
+    len = std::min(len, size_ - offset);
+    len = std::min(len, buffer_.size() - pos);
+    return buffer_.data() + pos;
+}
+
+void RingBuffer::consume(size_t len) {
+    len = std::min(len, size_);
+    size_t held = size_;
+    size_ -= len;
+    // 读空后回到开头，减少后续跨越末尾的情况
+    read_pos_ = (size_ == 0) ? 0 : ((read_pos_ + len) & (buffer_.size() - 1));
+    shrinkIfIdle(held);
+}
+
+void RingBuffer::clear() {
+    read_pos_ = 0;
+    size_ = 0;
+    // 清空是出错后的重置，直接缩回初始容量
+    if (buffer_.size() > initial_capacity_) {
+        reallocate(initial_capacity_);
+    }
+    idle_consumes_ = 0;
+}
@@ -0,0 +1,54 @@
+#ifndef __RING_BUFFER_H__
+#define __RING_BUFFER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// 可自动扩容的字节环形缓冲区，用于缓存网络上收到但还未解析完的字节流。
+// 写入整块拷贝，读取后只移动读指针，不会像vector::erase那样搬移剩余数据。
+// 为大帧扩容后，连续多次读取前缓存的数据都不到容量的1/4、且缓冲区已读空时缩回初始容量，
+// 空闲连接不长期占用大块内存，大帧和小帧交替到达时也不会反复扩容、缩容。
+class RingBuffer {
+private:
+    std::vector<uint8_t> buffer_; // 存储空间，容量始终为2的幂
+    size_t initial_capacity_;     // 初始容量，缩容时回到该大小
+    size_t read_pos_;             // 读位置
+    size_t size_;                 // 可读字节数
+    size_t idle_consumes_;        // 扩容后连续多少次读取前缓存的数据都不到容量的1/4
+
+    // 重新分配为capacity字节，数据从0开始连续存放，capacity不能小于size_
+    void reallocate(size_t capacity);
+    // 扩容到至少能容纳min_capacity字节
+    void grow(size_t min_capacity);
+    // 每次读取后调用，held为读取前缓存的字节数：扩容过且持续空闲时缩回初始容量
+    void shrinkIfIdle(size_t held);
+    // 把可读数据搬移到缓冲区开头，使其连续
+    void linearize();
+
+public:
+    explicit RingBuffer(size_t initial_capacity = 4096);
+
+    // 追加数据到缓冲区尾部，空间不足时自动扩容
+    void append(const void* data, size_t len);
+
+    // 获取从读位置开始len字节的连续内存，数据跨越缓冲区末尾时先整理为连续，len不能超过size()
+    const uint8_t* peek(size_t len);
+
+    // 获取从读位置偏移offset处开始的连续数据，不整理缓冲区；
+    // len传入需要的字节数，返回时为实际连续可读的字节数（数据跨越末尾时会变小）
+    const uint8_t* segment(size_t offset, size_t& len) const;
+
+    // 丢弃读位置开始的len字节
+    void consume(size_t len);
+
+    // 清空缓冲区
+    void clear();
+
+    // 可读字节数
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return buffer_.size(); }
+};
+
+#endif // __RING_BUFFER_H__
@@ -1,6 +1,7 @@
 #include "studentService.h"
 #include "studentDao.h"
 #include "UserService.h"
+#include "DatabaseManager.h"
 #include <string>
 
 StudentService* StudentService::instance = nullptr;
@@ -56,6 +57,38 @@ json StudentService::getStudentList(int page, int pageSize, int userId) {
     return response;
 }
 
+json StudentService::streamStudentList(int userId, std::string& after, size_t limit, const std::function<void(json& row)>& on_row) {
+    json response;
+    
+    // 权限检查
+    UserService* userService = UserService::getInstance();
+    if (!userService->checkPermission(userId, "view_student")) {
+        response["success"] = false;
+        response["message"] = "无权限查看学生信息";
+        return response;
+    }
+    
+    try {
+        bool completed = DatabaseManager::getInstance()->streamStudentList(after, limit, [&after, &on_row](json& row) {
+            // 行交给on_row后可能被移走，先记下游标
+            if (row.contains("number") && row["number"].is_string()) {
+                after = row["number"].get<std::string>();
+            }
+            on_row(row);
+            return true;
+        });
+        response["success"] = completed;
+        if (!completed) {
+            response["message"] = "获取学生列表失败";
+        }
+    } catch (const std::exception& e) {
+        response["success"] = false;
+        response["message"] = "获取学生列表失败: " + std::string(e.what());
+    }
+    
+    return response;
+}
+
 json StudentService::searchStudent(const std::string& keyword, int userId) {
     json response;
     
@@ -1,6 +1,7 @@
 #pragma once
 #include "studentModel.h"
 #include <vector>
+#include <functional>
 #include "json.hpp"
 
 using json = nlohmann::json;
@@ -16,6 +17,9 @@ public:
 
     // 学生信息管理服务
     json getStudentList(int page, int pageSize, int userId);
+    // 按学号顺序读取学号在after之后的至多limit个学生交给on_row，并把after推进到最后一个学生的学号，
+    // 用于分批流式返回（after为空时从头开始）；返回结果中只有success/message
+    json streamStudentList(int userId, std::string& after, size_t limit, const std::function<void(json& row)>& on_row);
     json searchStudent(const std::string& keyword, int userId);
     json getStudentDetail(int studentId, int userId);
     json addStudent(const json& studentData, int userId);
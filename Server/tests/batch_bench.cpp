@@ -0,0 +1,217 @@
+// 批量请求的基准测试：桌面客户端打开一条学生记录时的4个只读查询（1002权限、2003详情、2002搜索、3002任务状态），
+// 分别发送4帧 与 合并为一个4001批量请求 的帧数、字节数和服务器侧协议开销（不做断言）
+// 编译：g++ -std=c++17 -O2 -I.. batch_bench.cpp ../MyProto.cpp ../crc16.cpp ../ring_buffer.cpp ../body_compression.cpp ../request_schema.cpp -lzstd
+// 运行：./batch_bench > /dev/null，结果输出到标准错误
+// 服务器侧开销只含解码（CRC、模式校验）、子请求组装和响应编码，处理函数本身的数据库耗时两种方式相同，不计入。
+// 单个客户端每秒能打开的记录数按 往返次数 x RTT + 服务器侧开销 估算（RTT取0.2、2、20毫秒）：分别发送时每个查询等待上一个的响应
+#include "MyProto.h"
+#include "request_schema.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+namespace {
+
+const int ITERATIONS = 2000;
+const uint16_t BATCH_SERVER_ID = 4001;
+
+struct Lookup {
+    uint16_t server;
+    nlohmann::json data;    // 请求数据
+    nlohmann::json result;  // 处理函数结果（setResponse的输入）
+};
+
+nlohmann::json makeStudent(int i) {
+    return nlohmann::json{
+        { "id", i }, { "studentId", "2023" + std::to_string(100000 + i) }, { "name", "学生" + std::to_string(i) },
+        { "gender", i % 2 ? "男" : "女" }, { "birthday", "2004-05-17" }, { "idCard", "11010520040517" + std::to_string(1000 + i) },
+        { "phone", "1381234" + std::to_string(1000 + i) }, { "email", "student" + std::to_string(i) + "@example.edu.cn" },
+        { "university", "示例大学" }, { "province", "北京市" }, { "city", "北京市" }, { "address", "海淀区学院路" + std::to_string(i % 40) + "号" },
+        { "college", "计算机学院" }, { "department", "计算机科学与技术系" }, { "major", "软件工程" },
+        { "className", "软件" + std::to_string(2301 + i % 6) + "班" }, { "grade", 2023 }, { "educationLevel", "本科" },
+        { "enrollmentDate", "2023-09-01" }, { "graduationDate", "2027-06-30" }, { "status", "在读" },
+        { "politicalStatus", "共青团员" }, { "nation", "汉族" }, { "dormitory", std::to_string(1 + i % 12) + "号楼" + std::to_string(100 + i % 300) },
+        { "tutor", "张老师" }, { "gpa", 3.2 + (i % 8) / 10.0 }, { "credits", 60 + i % 40 },
+        { "createdAt", "2023-09-01 08:00:00" }, { "updatedAt", "2024-03-12 17:45:09" }
+    };
+}
+
+std::vector<Lookup> makeLookups() {
+    nlohmann::json matches = nlohmann::json::array();
+    for (int i = 0; i < 5; ++i) {
+        matches.push_back(makeStudent(40 + i));
+    }
+    return {
+        { 1002, nlohmann::json::object(),
+          { { "success", true }, { "permissions", { "student.read", "student.write", "student.export", "task.read", "task.submit", "user.read" } } } },
+        { 2003, { { "studentId", 42 } }, { { "success", true }, { "data", makeStudent(42) } } },
+        { 2002, { { "keyword", "软件2303" } }, { { "success", true }, { "data", matches } } },
+        { 3002, { { "taskId", "task-20240312-0042" } }, { { "success", true }, { "status", "completed" }, { "progress", 100 } } },
+    };
+}
+
+// 与EnhancedBussinessHandler.cpp中的请求模式一致
+void registerSchemas() {
+    registerRequestSchema(2002, RequestSchema().optional("keyword", SCHEMA_STRING, 256));
+    registerRequestSchema(2003, RequestSchema().required("studentId", SCHEMA_INTEGER));
+    registerRequestSchema(3002, RequestSchema().required("taskId", SCHEMA_STRING, 64));
+    registerRequestSchema(BATCH_SERVER_ID, RequestSchema().required("requests", SCHEMA_ARRAY, 32));
+    registerRawBodyService(2002);
+    registerRawBodyService(2003);
+}
+
+MyProtoMsg makeRequest(uint16_t server, uint32_t sequence, const nlohmann::json& data) {
+    MyProtoMsg msg;
+    msg.head.version = MY_PROTO_VERSION_NESTED_DATA;
+    msg.head.server = server;
+    msg.head.sequence = sequence;
+    msg.head.type = MY_PROTO_TYPE_DATA;
+    msg.body = { { "userId", 7 }, { "data", data } };
+    return msg;
+}
+
+// 与EnhancedBusinessHandler::setResponse一致（v2）
+void fillResponse(const MyProtoHead& request, const nlohmann::json& result, MyProtoMsg& response) {
+    response.head = request;
+    response.body = nlohmann::json::object();
+    response.body["data"] = result;
+    response.body["success"] = result.value("success", false);
+}
+
+struct Sample {
+    int frames;           // 两个方向的帧数，含客户端对可靠响应的确认帧
+    int roundTrips;
+    size_t requestBytes;
+    size_t responseBytes;
+    double serverUs;      // 每次打开记录的服务器侧协议开销
+};
+
+// 分别发送：每个查询一帧请求、一帧响应。只读服务的响应最多发送一次，不确认也不进入重发队列
+bool benchSeparate(const std::vector<Lookup>& lookups, Sample& sample) {
+    MyProtoEncode encoder;
+    std::vector<std::string> requests;
+    for (size_t i = 0; i < lookups.size(); ++i) {
+        MyProtoMsg msg = makeRequest(lookups[i].server, (uint32_t)i + 1, lookups[i].data);
+        std::string frame;
+        encoder.encode(&msg, frame);
+        requests.push_back(frame);
+    }
+
+    MyProtoDecode decoder;
+    decoder.init();
+    std::string response_frame;
+    sample = Sample();
+    auto start = std::chrono::steady_clock::now();
+    for (int iteration = 0; iteration < ITERATIONS; ++iteration) {
+        sample.responseBytes = 0;
+        for (size_t i = 0; i < lookups.size(); ++i) {
+            if (!decoder.parser(&requests[i][0], requests[i].size()) || decoder.empty()) {
+                std::cerr << "separate: decode failed for " << lookups[i].server << std::endl;
+                return false;
+            }
+            MyProtoMsg response;
+            fillResponse(decoder.front()->head, lookups[i].result, response);
+            decoder.pop();
+            encoder.encode(&response, response_frame);
+            sample.responseBytes += response_frame.size();
+        }
+    }
+    sample.serverUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+    for (const std::string& frame : requests) {
+        sample.requestBytes += frame.size();
+    }
+    sample.frames = (int)lookups.size() * 2;
+    sample.roundTrips = (int)lookups.size();
+    return true;
+}
+
+// 批量请求：一帧请求、一帧响应；4001按默认的可靠投递，请求的确认由响应捎带，客户端再确认一次响应
+bool benchBatch(const std::vector<Lookup>& lookups, Sample& sample) {
+    nlohmann::json items = nlohmann::json::array();
+    for (const Lookup& lookup : lookups) {
+        items.push_back({ { "serverId", lookup.server }, { "data", lookup.data } });
+    }
+    MyProtoEncode encoder;
+    MyProtoMsg batch = makeRequest(BATCH_SERVER_ID, 1, { { "requests", items } });
+    std::string request_frame;
+    encoder.encode(&batch, request_frame);
+
+    MyProtoDecode decoder;
+    decoder.init();
+    std::string response_frame;
+    sample = Sample();
+    auto start = std::chrono::steady_clock::now();
+    for (int iteration = 0; iteration < ITERATIONS; ++iteration) {
+        if (!decoder.parser(&request_frame[0], request_frame.size()) || decoder.empty()) {
+            std::cerr << "batch: decode failed" << std::endl;
+            return false;
+        }
+        std::shared_ptr<MyProtoMsg> request = decoder.front();
+        decoder.pop();
+
+        // 与EnhancedBusinessHandler::prepareBatchItem一致：组装子请求，按子服务的模式再校验一遍
+        const nlohmann::json& received = request->body["data"]["requests"];
+        nlohmann::json results = nlohmann::json::array();
+        for (size_t i = 0; i < received.size(); ++i) {
+            uint16_t server = received[i]["serverId"].get<uint16_t>();
+            nlohmann::json body = { { "userId", request->body["userId"] }, { "data", received[i]["data"] } };
+            std::string text = body.dump();
+            MyProtoMsg sub;
+            std::string error;
+            bool raw = isRawBodyService(server);
+            if (!validateRequestBody((const uint8_t*)text.data(), text.size(), MY_PROTO_CODEC_JSON,
+                                     findRequestSchema(server), raw ? nullptr : &sub.body, error)) {
+                std::cerr << "batch: item " << server << " rejected: " << error << std::endl;
+                return false;
+            }
+            if (raw) {
+                sub.rawBody = std::move(text);
+            }
+            MyProtoMsg sub_response;
+            fillResponse(request->head, lookups[i].result, sub_response);
+            nlohmann::json item = std::move(sub_response.body);
+            item["serverId"] = server;
+            results.push_back(std::move(item));
+        }
+        nlohmann::json result = { { "success", true }, { "message", "Batch processed: 4 requests" }, { "results", std::move(results) } };
+        MyProtoMsg response;
+        fillResponse(request->head, result, response);
+        encoder.encode(&response, response_frame);
+    }
+    sample.serverUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+    sample.requestBytes = request_frame.size();
+    sample.responseBytes = response_frame.size() + MY_PROTO_HEAD_SIZE;  // 加上客户端的确认帧
+    sample.frames = 3;
+    sample.roundTrips = 1;
+    return true;
+}
+
+void report(const char* name, const Sample& sample) {
+    std::cerr << std::left << std::setw(10) << name << std::right << std::setw(8) << sample.frames
+              << std::setw(8) << sample.roundTrips << std::setw(12) << sample.requestBytes
+              << std::setw(12) << sample.responseBytes << std::fixed << std::setprecision(1)
+              << std::setw(12) << sample.serverUs;
+    for (double rtt_ms : { 0.2, 2.0, 20.0 }) {
+        std::cerr << std::setw(12) << std::setprecision(0) << 1e6 / (sample.roundTrips * rtt_ms * 1000 + sample.serverUs);
+    }
+    std::cerr << std::endl;
+}
+
+} // namespace
+
+int main() {
+    registerSchemas();
+    std::vector<Lookup> lookups = makeLookups();
+    Sample separate, batch;
+    if (!benchSeparate(lookups, separate) || !benchBatch(lookups, batch)) {
+        return 1;
+    }
+    std::cerr << "4 read-only lookups per record open, " << ITERATIONS << " iterations" << std::endl;
+    std::cerr << std::left << std::setw(10) << "mode" << std::right << std::setw(8) << "frames" << std::setw(8) << "trips"
+              << std::setw(12) << "req bytes" << std::setw(12) << "resp bytes" << std::setw(12) << "server us"
+              << std::setw(12) << "open/s@0.2" << std::setw(12) << "open/s@2" << std::setw(12) << "open/s@20" << std::endl;
+    report("separate", separate);
+    report("batch", batch);
+    return 0;
+}
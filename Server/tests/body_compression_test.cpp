@@ -0,0 +1,91 @@
+// 消息体压缩的单元测试：往返、不可压缩的数据、解压长度上限、损坏的数据和多线程
+// 编译：g++ -std=c++17 -I.. body_compression_test.cpp ../body_compression.cpp -lzstd -pthread
+#include "body_compression.h"
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::string studentRows(int rows) {
+    std::string text = "[";
+    for (int i = 0; i < rows; ++i) {
+        text += "{\"studentId\":\"2023" + std::to_string(100000 + i) + "\",\"university\":\"示例大学\","
+                "\"province\":\"北京市\",\"college\":\"计算机学院\",\"major\":\"软件工程\"},";
+    }
+    text.back() = ']';
+    return text;
+}
+
+// 压缩结果追加在out已有内容之后，解压覆盖out
+void testRoundTrip() {
+    std::string body = studentRows(100);
+    std::string out = "HEAD";
+    assert(compressBody((const uint8_t*)body.data(), body.size(), out));
+    assert(out.compare(0, 4, "HEAD") == 0 && out.size() < body.size() / 4);
+
+    std::string restored = "stale";
+    assert(decompressBody((const uint8_t*)out.data() + 4, out.size() - 4, body.size(), restored));
+    assert(restored == body);
+}
+
+// 压缩后没有变小时返回false，out不变
+void testIncompressible() {
+    std::mt19937 rng(7);
+    std::string noise(256, '\0');
+    for (char& c : noise) {
+        c = (char)rng();
+    }
+    std::string out = "HEAD";
+    assert(!compressBody((const uint8_t*)noise.data(), noise.size(), out));
+    assert(out == "HEAD");
+}
+
+// 解压后超过上限的帧、截断的帧和不是zstd格式的数据都拒绝
+void testRejectInvalid() {
+    std::string body = studentRows(50);
+    std::string compressed;
+    assert(compressBody((const uint8_t*)body.data(), body.size(), compressed));
+
+    std::string out;
+    assert(!decompressBody((const uint8_t*)compressed.data(), compressed.size(), body.size() - 1, out));
+
+    // 截断的帧（zstd默认不带校验和，改写中间字节不一定能检测出来）
+    assert(!decompressBody((const uint8_t*)compressed.data(), compressed.size() - 3, body.size(), out));
+
+    const std::string garbage = "not a zstd frame";
+    assert(!decompressBody((const uint8_t*)garbage.data(), garbage.size(), 1024, out));
+}
+
+// 压缩上下文每个线程一份，多个线程可以同时压缩和解压
+void testThreads() {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t]() {
+            std::string body = studentRows(20 + t * 10);
+            for (int i = 0; i < 200; ++i) {
+                std::string compressed, restored;
+                assert(compressBody((const uint8_t*)body.data(), body.size(), compressed));
+                assert(decompressBody((const uint8_t*)compressed.data(), compressed.size(), body.size(), restored));
+                assert(restored == body);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace
+
+int main() {
+    setCompressionConfig(256, 3);
+    testRoundTrip();
+    testIncompressible();
+    testRejectInvalid();
+    testThreads();
+    std::cout << "body_compression_test passed" << std::endl;
+    return 0;
+}
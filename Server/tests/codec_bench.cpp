@@ -0,0 +1,138 @@
+// 消息体编码方式和压缩的基准测试：学生列表响应在各编码方式下的帧大小、编码和解码耗时（不做断言），
+// 每种编码方式并排列出v1（data为JSON字符串）和v2（data直接嵌套）信封
+// 编译：g++ -std=c++17 -O2 -I.. codec_bench.cpp ../MyProto.cpp ../crc16.cpp ../ring_buffer.cpp ../body_compression.cpp ../request_schema.cpp -lzstd
+// 运行：./codec_bench [字典路径] > /dev/null，给出字典时压缩使用该字典。
+// 结果输出到标准错误，编解码器自带的调试输出在标准输出，需重定向丢弃以免影响计时
+#include "MyProto.h"
+#include "body_compression.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+namespace {
+
+const int ROWS = 200;        // 一页学生的行数（2001/2002的响应）
+const int ITERATIONS = 200;
+const size_t COMPRESSION_THRESHOLD = 1024;
+
+// 与studentinfo表相同的29列
+nlohmann::json makeStudent(int i) {
+    return nlohmann::json{
+        { "id", i }, { "studentId", "2023" + std::to_string(100000 + i) }, { "name", "学生" + std::to_string(i) },
+        { "gender", i % 2 ? "男" : "女" }, { "birthday", "2004-05-17" }, { "idCard", "11010520040517" + std::to_string(1000 + i) },
+        { "phone", "1381234" + std::to_string(1000 + i) }, { "email", "student" + std::to_string(i) + "@example.edu.cn" },
+        { "university", "示例大学" }, { "province", "北京市" }, { "city", "北京市" }, { "address", "海淀区学院路" + std::to_string(i % 40) + "号" },
+        { "college", "计算机学院" }, { "department", "计算机科学与技术系" }, { "major", "软件工程" },
+        { "className", "软件" + std::to_string(2301 + i % 6) + "班" }, { "grade", 2023 }, { "educationLevel", "本科" },
+        { "enrollmentDate", "2023-09-01" }, { "graduationDate", "2027-06-30" }, { "status", "在读" },
+        { "politicalStatus", "共青团员" }, { "nation", "汉族" }, { "dormitory", std::to_string(1 + i % 12) + "号楼" + std::to_string(100 + i % 300) },
+        { "tutor", "张老师" }, { "gpa", 3.2 + (i % 8) / 10.0 }, { "credits", 60 + i % 40 },
+        { "createdAt", "2023-09-01 08:00:00" }, { "updatedAt", "2024-03-12 17:45:09" }
+    };
+}
+
+// 2001的处理函数结果（setResponse的输入）
+nlohmann::json makeListResult() {
+    nlohmann::json students = nlohmann::json::array();
+    for (int i = 0; i < ROWS; ++i) {
+        students.push_back(makeStudent(i));
+    }
+    return { { "success", true }, { "total", ROWS }, { "page", 1 }, { "data", students } };
+}
+
+// 与EnhancedBusinessHandler::setResponse一致：v2把结果直接嵌套在data中，v1把结果序列化为字符串
+void fillResponse(const nlohmann::json& result, uint8_t version, MyProtoMsg& msg) {
+    msg.head.version = version;
+    msg.head.server = 2001;
+    msg.head.sequence = 1;
+    msg.head.type = MY_PROTO_TYPE_DATA;
+    msg.body = nlohmann::json::object();
+    if (version >= MY_PROTO_VERSION_NESTED_DATA) {
+        msg.body["data"] = result;
+    } else {
+        msg.body["data"] = result.dump();
+    }
+    msg.body["success"] = true;
+}
+
+struct Sample {
+    size_t bytes;
+    double encodeUs;  // 填充响应体（v1含dump）加编码
+    double decodeUs;  // 解码（v1含客户端对data字符串的再次解析）
+};
+
+// 帧解码失败时返回false，耗时不能作数
+bool benchCodec(const char* name, uint8_t version, uint8_t flags, const nlohmann::json& result, Sample& sample) {
+    MyProtoEncode encoder;
+    std::string frame;
+    MyProtoMsg msg;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        fillResponse(result, version, msg);
+        msg.head.flags = flags; // 编码时会改写标志位（消息体小于压缩阈值时清除压缩标志）
+        encoder.encode(&msg, frame);
+    }
+    sample.encodeUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+    sample.bytes = frame.size();
+
+    MyProtoDecode decoder;
+    decoder.init();
+    size_t rows = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        // 不依赖assert，-DNDEBUG编译时也要检查
+        bool parsed = decoder.parser(&frame[0], frame.size());
+        if (!parsed || decoder.empty()) {
+            std::cerr << name << " v" << (int)version << ": decode failed" << std::endl;
+            return false;
+        }
+        const nlohmann::json& data = decoder.front()->body["data"];
+        if (data.is_string()) {
+            rows = nlohmann::json::parse(data.get_ref<const std::string&>())["data"].size();
+        } else {
+            rows = data["data"].size();
+        }
+        decoder.pop();
+    }
+    sample.decodeUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+    if (rows != (size_t)ROWS) {
+        std::cerr << name << " v" << (int)version << ": decoded " << rows << " rows" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 同一编码方式下v1和v2并排输出
+bool benchEnvelopes(const char* name, uint8_t flags, const nlohmann::json& result) {
+    Sample v1, v2;
+    if (!benchCodec(name, 1, flags, result, v1) || !benchCodec(name, MY_PROTO_VERSION_NESTED_DATA, flags, result, v2)) {
+        return false;
+    }
+    std::cerr << std::left << std::setw(14) << name << std::right
+              << std::setw(10) << v1.bytes << std::setw(10) << v2.bytes << std::fixed << std::setprecision(1)
+              << std::setw(10) << v1.encodeUs << std::setw(10) << v2.encodeUs
+              << std::setw(10) << v1.decodeUs << std::setw(10) << v2.decodeUs << std::endl;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    setCompressionConfig(COMPRESSION_THRESHOLD, 3);
+    if (argc > 1 && !loadCompressionDictionary(argv[1])) {
+        return 1;
+    }
+    nlohmann::json result = makeListResult();
+
+    std::cerr << ROWS << " rows, " << ITERATIONS << " iterations; v1 = data as a JSON string, v2 = nested data" << std::endl;
+    std::cerr << std::left << std::setw(14) << "codec" << std::right << std::setw(10) << "v1 bytes" << std::setw(10) << "v2 bytes"
+              << std::setw(10) << "v1 enc" << std::setw(10) << "v2 enc" << std::setw(10) << "v1 dec" << std::setw(10) << "v2 dec"
+              << "  (us)" << std::endl;
+    bool ok = benchEnvelopes("json", MY_PROTO_CODEC_JSON, result) &&
+              benchEnvelopes("msgpack", MY_PROTO_CODEC_MSGPACK, result) &&
+              benchEnvelopes("cbor", MY_PROTO_CODEC_CBOR, result) &&
+              benchEnvelopes("json+zstd", MY_PROTO_CODEC_JSON | MY_PROTO_FLAG_COMPRESSED, result) &&
+              benchEnvelopes("msgpack+zstd", MY_PROTO_CODEC_MSGPACK | MY_PROTO_FLAG_COMPRESSED, result) &&
+              benchEnvelopes("cbor+zstd", MY_PROTO_CODEC_CBOR | MY_PROTO_FLAG_COMPRESSED, result);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+// 消息体压缩的基准测试：学生详情、列表页和批量导入的消息体在 不压缩、zstd、zstd加字典 下的大小和压缩/解压耗时（不做断言）
+// 编译：g++ -std=c++17 -O2 -I.. compression_bench.cpp ../body_compression.cpp -lzstd -pthread
+// 运行：./compression_bench [字典路径]，给出字典时另列出使用字典的结果
+// 训练字典：./compression_bench --samples <目录> 写出样本行（每行一个文件，与测量用的行不同），
+//           再执行 zstd --train <目录>/* --maxdict=16384 -o student.dict
+// 行数据按studentinfo的29列生成，姓名、证件号、电话、院系等字段随机取值，避免重复度过高
+#include "body_compression.h"
+#include "json.hpp"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int ITERATIONS = 200;
+const int COMPRESSION_LEVEL = 3;  // 与Server.cpp一致
+
+const char* SURNAMES[] = { "王", "李", "张", "刘", "陈", "杨", "黄", "赵", "吴", "周", "徐", "孙", "马", "朱", "胡" };
+const char* GIVEN[] = { "伟", "芳", "娜", "敏", "静", "磊", "洋", "艳", "勇", "军", "杰", "娟", "涛", "明", "超", "秀英", "子涵", "浩然" };
+const char* PROVINCES[] = { "北京市", "河北省", "山东省", "江苏省", "浙江省", "广东省", "四川省", "湖北省", "河南省", "陕西省" };
+const char* COLLEGES[][3] = {
+    { "计算机学院", "计算机科学与技术系", "软件工程" },
+    { "计算机学院", "网络工程系", "信息安全" },
+    { "电子信息学院", "通信工程系", "通信工程" },
+    { "经济管理学院", "工商管理系", "会计学" },
+    { "外国语学院", "英语系", "英语" },
+    { "机械工程学院", "机械设计系", "机械设计制造及其自动化" },
+};
+const char* POLITICAL[] = { "共青团员", "群众", "中共党员" };
+const char* NATIONS[] = { "汉族", "汉族", "汉族", "回族", "满族", "壮族" };
+
+template <size_t N>
+const char* pick(const char* const (&values)[N], std::mt19937& rng) {
+    return values[rng() % N];
+}
+
+std::string digits(std::mt19937& rng, int count) {
+    std::string text;
+    for (int i = 0; i < count; ++i) {
+        text += (char)('0' + rng() % 10);
+    }
+    return text;
+}
+
+// 与studentinfo表相同的29列
+nlohmann::json makeStudent(int id, std::mt19937& rng) {
+    const char* const* college = COLLEGES[rng() % (sizeof(COLLEGES) / sizeof(COLLEGES[0]))];
+    int grade = 2020 + rng() % 4;
+    std::string birthday = std::to_string(grade - 19) + "-0" + std::to_string(1 + rng() % 9) + "-1" + std::to_string(rng() % 10);
+    std::string name = std::string(pick(SURNAMES, rng)) + pick(GIVEN, rng);
+    return nlohmann::json{
+        { "id", id }, { "studentId", std::to_string(grade) + digits(rng, 6) }, { "name", name },
+        { "gender", rng() % 2 ? "男" : "女" }, { "birthday", birthday }, { "idCard", "1101" + digits(rng, 14) },
+        { "phone", "13" + digits(rng, 9) }, { "email", "s" + digits(rng, 8) + "@example.edu.cn" },
+        { "university", "示例大学" }, { "province", pick(PROVINCES, rng) }, { "city", "市辖区" },
+        { "address", std::string("学院路") + std::to_string(1 + rng() % 200) + "号" + std::to_string(1 + rng() % 30) + "栋" },
+        { "college", college[0] }, { "department", college[1] }, { "major", college[2] },
+        { "className", std::string(college[2]).substr(0, 6) + std::to_string(grade % 100) + "0" + std::to_string(1 + rng() % 6) + "班" },
+        { "grade", grade }, { "educationLevel", "本科" },
+        { "enrollmentDate", std::to_string(grade) + "-09-01" }, { "graduationDate", std::to_string(grade + 4) + "-06-30" },
+        { "status", rng() % 20 ? "在读" : "休学" }, { "politicalStatus", pick(POLITICAL, rng) }, { "nation", pick(NATIONS, rng) },
+        { "dormitory", std::to_string(1 + rng() % 12) + "号楼" + std::to_string(100 + rng() % 500) },
+        { "tutor", std::string(pick(SURNAMES, rng)) + "老师" }, { "gpa", (200 + rng() % 200) / 100.0 }, { "credits", 20 + rng() % 140 },
+        { "createdAt", std::to_string(grade) + "-09-01 08:00:00" },
+        { "updatedAt", "2024-0" + std::to_string(1 + rng() % 9) + "-1" + std::to_string(rng() % 10) + " 1" + std::to_string(rng() % 10) + ":3" + std::to_string(rng() % 10) + ":0" + std::to_string(rng() % 10) }
+    };
+}
+
+nlohmann::json makeRows(int count, std::mt19937& rng) {
+    nlohmann::json rows = nlohmann::json::array();
+    for (int i = 0; i < count; ++i) {
+        rows.push_back(makeStudent(1000 + i, rng));
+    }
+    return rows;
+}
+
+struct Body {
+    const char* name;
+    std::string text;  // JSON编码的消息体
+};
+
+std::vector<Body> makeBodies() {
+    std::mt19937 rng(2024);
+    std::vector<Body> bodies;
+    nlohmann::json detail = { { "success", true }, { "data", { { "success", true }, { "data", makeStudent(1, rng) } } } };
+    bodies.push_back({ "2003 detail", detail.dump() });
+    nlohmann::json page = { { "success", true }, { "data", { { "success", true }, { "total", 3000 }, { "page", 1 }, { "data", makeRows(20, rng) } } } };
+    bodies.push_back({ "2001 20 rows", page.dump() });
+    page["data"]["data"] = makeRows(200, rng);
+    bodies.push_back({ "2001 200 rows", page.dump() });
+    nlohmann::json import = { { "userId", 7 }, { "data", { { "students", makeRows(500, rng) } } } };
+    bodies.push_back({ "3005 500 rows", import.dump() });
+    return bodies;
+}
+
+struct Sample {
+    size_t bytes;
+    double compressUs;
+    double decompressUs;
+};
+
+bool benchBody(const Body& body, Sample& sample) {
+    const uint8_t* src = (const uint8_t*)body.text.data();
+    std::string compressed;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        compressed.clear();
+        if (!compressBody(src, body.text.size(), compressed)) {
+            std::cerr << body.name << ": compress failed" << std::endl;
+            return false;
+        }
+    }
+    sample.compressUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+    sample.bytes = compressed.size();
+
+    std::string restored;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        if (!decompressBody((const uint8_t*)compressed.data(), compressed.size(), body.text.size(), restored)) {
+            std::cerr << body.name << ": decompress failed" << std::endl;
+            return false;
+        }
+    }
+    sample.decompressUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+    if (restored != body.text) {
+        std::cerr << body.name << ": round trip mismatch" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool writeSamples(const std::string& dir) {
+    std::mt19937 rng(1);
+    for (int i = 0; i < 2000; ++i) {
+        std::ofstream file(dir + "/row" + std::to_string(i) + ".json", std::ios::binary);
+        if (!file) {
+            std::cerr << "cannot write samples to " << dir << std::endl;
+            return false;
+        }
+        file << makeStudent(i, rng).dump();
+    }
+    return true;
+}
+
+bool benchAll(const std::vector<Body>& bodies, std::vector<Sample>& samples) {
+    samples.resize(bodies.size());
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        if (!benchBody(bodies[i], samples[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc > 2 && std::string(argv[1]) == "--samples") {
+        return writeSamples(argv[2]) ? 0 : 1;
+    }
+    setCompressionConfig(1, COMPRESSION_LEVEL);
+    std::vector<Body> bodies = makeBodies();
+
+    // 字典为进程内全局设置，先测不用字典的，再加载字典
+    std::vector<Sample> plain, dict;
+    if (!benchAll(bodies, plain)) {
+        return 1;
+    }
+    bool has_dict = argc > 1;
+    if (has_dict && (!loadCompressionDictionary(argv[1]) || !benchAll(bodies, dict))) {
+        return 1;
+    }
+
+    std::cout << "zstd level " << COMPRESSION_LEVEL << ", " << ITERATIONS << " iterations, bytes and us per body" << std::endl;
+    std::cout << std::left << std::setw(16) << "body" << std::right << std::setw(10) << "raw"
+              << std::setw(10) << "zstd" << std::setw(10) << "comp" << std::setw(10) << "decomp";
+    if (has_dict) {
+        std::cout << std::setw(10) << "+dict" << std::setw(10) << "comp" << std::setw(10) << "decomp";
+    }
+    std::cout << std::endl;
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        std::cout << std::left << std::setw(16) << bodies[i].name << std::right << std::setw(10) << bodies[i].text.size()
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(10) << plain[i].bytes << std::setw(10) << plain[i].compressUs << std::setw(10) << plain[i].decompressUs;
+        if (has_dict) {
+            std::cout << std::setw(10) << dict[i].bytes << std::setw(10) << dict[i].compressUs << std::setw(10) << dict[i].decompressUs;
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+// CRC-16的单元测试：与逐位计算的参考实现对照
+// 编译：g++ -std=c++17 -I.. crc16_test.cpp ../crc16.cpp
+// updateCRC对短数据用slice-by-8查表，CPU支持PCLMULQDQ时长数据改用无进位乘法，
+// 长度从0覆盖到数千字节即可同时检查两种实现
+#include "crc16.h"
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+uint16_t referenceCRC(uint16_t crc, const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)(data[i] << 8);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+std::vector<uint8_t> randomBytes(size_t length, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> data(length);
+    for (uint8_t& byte : data) {
+        byte = (uint8_t)rng();
+    }
+    return data;
+}
+
+void testCheckValue() {
+    const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    assert(updateCRC(0xFFFF, check, sizeof(check)) == 0x29B1);
+}
+
+// 各种长度和起始对齐都与参考实现一致
+void testAgainstReference() {
+    std::vector<uint8_t> data = randomBytes(4096 + 16, 1);
+    for (size_t length = 0; length <= 4096; length += (length < 300 ? 1 : 37)) {
+        for (size_t offset = 0; offset < 8; offset += 3) {
+            uint16_t expected = referenceCRC(0xFFFF, data.data() + offset, length);
+            assert(updateCRC(0xFFFF, data.data() + offset, length) == expected);
+            assert(updateCRCTable(0xFFFF, data.data() + offset, length) == expected);
+            assert(updateCRC(0x1234, data.data() + offset, length) == referenceCRC(0x1234, data.data() + offset, length));
+        }
+    }
+}
+
+// 分段计算等于整体计算，分段点落在查表和乘法实现的切换长度两侧
+void testSegmented() {
+    std::vector<uint8_t> data = randomBytes(3000, 2);
+    uint16_t whole = referenceCRC(0xFFFF, data.data(), data.size());
+    const size_t splits[] = { 1, 7, 63, 64, 65, 255, 256, 1024, 2999 };
+    for (size_t split : splits) {
+        uint16_t crc = updateCRC(0xFFFF, data.data(), split);
+        crc = updateCRC(crc, data.data() + split, data.size() - split);
+        assert(crc == whole);
+    }
+}
+
+// 线性组合：从状态s处理n字节 = multiplyCRC(s, shiftCRC(n)) ^ 从0处理同样数据
+void testShiftAndMultiply() {
+    std::vector<uint8_t> data = randomBytes(777, 3);
+    const uint16_t states[] = { 0xFFFF, 0x0001, 0xBEEF };
+    for (uint16_t state : states) {
+        for (size_t n : { (size_t)0, (size_t)1, (size_t)9, (size_t)777 }) {
+            uint16_t expected = referenceCRC(state, data.data(), n);
+            assert((multiplyCRC(state, shiftCRC(n)) ^ updateCRC(0, data.data(), n)) == expected);
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    testCheckValue();
+    testAgainstReference();
+    testSegmented();
+    testShiftAndMultiply();
+    std::cout << "crc16_test passed (" << crcImplementation() << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,148 @@
+// 确认合并的单元测试：按连接处理器的用法驱动N个请求（收到时登记，响应发出时捎带确认，
+// 延迟确认定时器到期时合并发出），统计发出的确认帧数
+// 编译：g++ -std=c++17 -I.. pending_acks_test.cpp ../pending_acks.cpp
+#include "pending_acks.h"
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+MyProtoHead requestHead(uint32_t sequence) {
+    MyProtoHead head = MyProtoHead();
+    head.version = 2;
+    head.server = 2003;
+    head.sequence = sequence;
+    head.type = MY_PROTO_TYPE_DATA;
+    return head;
+}
+
+// 一个确认延迟窗口：窗口内到达的请求先登记，responded中的请求在窗口内发出了响应，
+// 窗口结束时定时器把剩下的合并成至多一个确认帧
+void runWindow(PendingAcks& acks, const std::vector<uint32_t>& requests, const std::vector<uint32_t>& responded,
+               std::vector<MyProtoMsg>& frames) {
+    for (uint32_t sequence : requests) {
+        acks.add(requestHead(sequence));
+    }
+    for (uint32_t sequence : responded) {
+        acks.remove(sequence);
+    }
+    MyProtoMsg ack_msg;
+    if (acks.takeFrame(ack_msg)) {
+        frames.push_back(ack_msg);
+    }
+}
+
+// 不延迟确认（ack_delay为0）时每个请求一个确认帧，格式与原来相同，这是改动前的帧数
+void testOneFramePerRequestWithoutDelay() {
+    PendingAcks acks;
+    std::vector<MyProtoMsg> frames;
+    for (uint32_t sequence = 1; sequence <= 100; ++sequence) {
+        runWindow(acks, { sequence }, {}, frames);
+    }
+    assert(frames.size() == 100);
+    for (size_t i = 0; i < frames.size(); ++i) {
+        assert(frames[i].head.type == MY_PROTO_TYPE_ACK);
+        assert(frames[i].head.sequence == i + 1);
+        assert(frames[i].head.version == 2);
+        assert(frames[i].head.server == 2003);
+        assert(frames[i].body.find("sack") == frames[i].body.end());
+    }
+}
+
+// 响应都在延迟时间内发出：响应捎带确认，不发确认帧
+void testResponsesPiggyback() {
+    PendingAcks acks;
+    std::vector<MyProtoMsg> frames;
+    for (uint32_t sequence = 1; sequence <= 100; ++sequence) {
+        runWindow(acks, { sequence }, { sequence }, frames);
+    }
+    assert(frames.empty());
+    assert(acks.empty());
+}
+
+// 流水线客户端一个窗口内发了100个请求，响应都来不及发出：合并为一个确认帧
+void testSlowResponsesCoalesced() {
+    PendingAcks acks;
+    std::vector<MyProtoMsg> frames;
+    std::vector<uint32_t> requests;
+    for (uint32_t sequence = 1; sequence <= 100; ++sequence) {
+        requests.push_back(sequence);
+    }
+    runWindow(acks, requests, {}, frames);
+    assert(frames.size() == 1);
+    assert(frames[0].head.sequence == 100);
+    assert(frames[0].body["sack"] == nlohmann::json::parse("[[1,100]]"));
+    assert(acks.empty());
+}
+
+// 一半请求在窗口内得到响应：剩下的一半合并为一个帧，sack只列出没有被响应确认的序列号
+void testMixedWindow() {
+    PendingAcks acks;
+    std::vector<MyProtoMsg> frames;
+    std::vector<uint32_t> requests;
+    std::vector<uint32_t> responded;
+    for (uint32_t sequence = 1; sequence <= 8; ++sequence) {
+        requests.push_back(sequence);
+        if (sequence % 2 == 0) {
+            responded.push_back(sequence);
+        }
+    }
+    runWindow(acks, requests, responded, frames);
+    assert(frames.size() == 1);
+    assert(frames[0].head.sequence == 7);
+    assert(frames[0].body["sack"] == nlohmann::json::parse("[[1,1],[3,3],[5,5],[7,7]]"));
+}
+
+// 重发的请求让同一序列号登记了多次，只确认一次；只剩一个序列号时不带sack
+void testDuplicatesCollapsed() {
+    PendingAcks acks;
+    std::vector<MyProtoMsg> frames;
+    runWindow(acks, { 5, 5, 5 }, {}, frames);
+    assert(frames.size() == 1);
+    assert(frames[0].head.sequence == 5);
+    assert(frames[0].body.find("sack") == frames[0].body.end());
+
+    runWindow(acks, { 6, 7, 6, 9 }, {}, frames);
+    assert(frames.size() == 2);
+    assert(frames[1].head.sequence == 9);
+    assert(frames[1].body["sack"] == nlohmann::json::parse("[[6,7],[9,9]]"));
+}
+
+// 1000个请求，每个窗口8个，每个窗口有2个慢请求：每个窗口一个确认帧，是改动前的1/8
+void testFramesPerRequest() {
+    PendingAcks acks;
+    std::vector<MyProtoMsg> frames;
+    size_t acked = 0;
+    for (uint32_t base = 1; base <= 1000; base += 8) {
+        std::vector<uint32_t> requests;
+        std::vector<uint32_t> responded;
+        for (uint32_t sequence = base; sequence < base + 8; ++sequence) {
+            requests.push_back(sequence);
+            if (sequence - base < 6) {
+                responded.push_back(sequence);
+            }
+        }
+        runWindow(acks, requests, responded, frames);
+    }
+    assert(frames.size() == 125);
+    for (const MyProtoMsg& frame : frames) {
+        const nlohmann::json& ranges = frame.body["sack"];
+        assert(ranges.size() == 1);
+        acked += ranges[0][1].get<uint32_t>() - ranges[0][0].get<uint32_t>() + 1;
+    }
+    assert(acked == 250);
+}
+
+}  // namespace
+
+int main() {
+    testOneFramePerRequestWithoutDelay();
+    testResponsesPiggyback();
+    testSlowResponsesCoalesced();
+    testMixedWindow();
+    testDuplicatesCollapsed();
+    testFramesPerRequest();
+    std::cout << "pending_acks_test passed" << std::endl;
+    return 0;
+}
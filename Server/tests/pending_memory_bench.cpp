@@ -0,0 +1,108 @@
+// 发送窗口中待确认消息的内存占用：保存json消息 与 保存编码好的帧（基准测试，不做断言）
+// 编译：g++ -std=c++17 -O2 -I.. pending_memory_bench.cpp ../MyProto.cpp ../crc16.cpp ../ring_buffer.cpp ../body_compression.cpp ../request_schema.cpp ../reliable_msg_manager.cpp ../timing_wheel.cpp -lzstd -lhv
+// 运行：./pending_memory_bench > /dev/null，结果输出到标准错误
+#include "MyProto.h"
+#include "reliable_msg_manager.h"
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <new>
+#include <vector>
+
+namespace {
+// 在每块内存前记录大小，统计当前仍在使用的堆内存
+size_t g_live_bytes = 0;
+const size_t HEADER = 16;
+
+void* allocate(std::size_t size) {
+    char* block = (char*)std::malloc(size + HEADER);
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    *(size_t*)block = size;
+    g_live_bytes += size;
+    return block + HEADER;
+}
+
+void release(void* p) {
+    if (p) {
+        char* block = (char*)p - HEADER;
+        g_live_bytes -= *(size_t*)block;
+        std::free(block);
+    }
+}
+}
+
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    release(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    release(p);
+}
+
+namespace {
+
+const int MESSAGES = 10000;
+
+// 典型的推送和响应：一条学生记录
+MyProtoMsg makeMessage(int i) {
+    MyProtoMsg msg;
+    msg.head.version = 2;
+    msg.head.server = 2003;
+    msg.head.sequence = 0;
+    msg.head.type = MY_PROTO_TYPE_DATA;
+    msg.head.flags = 0;
+    msg.body = {
+        { "success", true },
+        { "data", {
+            { "id", i }, { "studentId", "2023" + std::to_string(100000 + i) }, { "name", "学生" + std::to_string(i) },
+            { "gender", "男" }, { "birthday", "2004-05-17" }, { "phone", "13812341234" },
+            { "email", "student" + std::to_string(i) + "@example.edu.cn" }, { "department", "计算机科学与技术系" },
+            { "major", "软件工程" }, { "className", "软件2301班" }, { "enrollmentDate", "2023-09-01" }, { "status", "在读" }
+        } }
+    };
+    return msg;
+}
+
+void report(const char* name, size_t bytes) {
+    std::cerr << std::left << std::setw(16) << name << std::right << std::setw(12) << bytes / 1024 << " KB"
+              << std::setw(10) << bytes / MESSAGES << " B/msg" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    std::vector<MyProtoMsg> source;
+    source.reserve(MESSAGES);
+    for (int i = 0; i < MESSAGES; ++i) {
+        source.push_back(makeMessage(i));
+    }
+
+    // 原来的做法：每条待确认消息深拷贝一份MyProtoMsg（含json消息体）
+    size_t before = g_live_bytes;
+    {
+        std::vector<MyProtoMsg> pending(source.begin(), source.end());
+        report("json copies", g_live_bytes - before);
+    }
+
+    // 现在的做法：发送窗口只保存编码好的帧
+    before = g_live_bytes;
+    {
+        ReliableMsgManager manager(3, 600000);
+        manager.setWindowConfig(MESSAGES, (size_t)-1, 0, 0);
+        manager.setTransmitCallback([](int, const PendingMessage&) {});
+        MyProtoEncode encoder;
+        for (MyProtoMsg& msg : source) {
+            MyProtoSharedFrame frame;
+            encoder.encodeShared(&msg, frame);
+            manager.sendReliable(1, frame);
+        }
+        report("encoded frames", g_live_bytes - before);
+    }
+    return 0;
+}
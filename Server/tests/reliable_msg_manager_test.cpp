@@ -0,0 +1,208 @@
+// 可靠消息管理器的单元测试：发送窗口、确认区间、重传超时的估计和退避
+// 编译：g++ -std=c++17 -I.. reliable_msg_manager_test.cpp ../reliable_msg_manager.cpp ../timing_wheel.cpp -lhv
+#include "reliable_msg_manager.h"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+long long elapsedMs(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count();
+}
+
+// 在事件循环中运行ms毫秒，期间超时检测定时器照常触发
+void runLoop(hloop_t* loop, uint32_t ms) {
+    htimer_t* timer = htimer_add(loop, [](htimer_t* t) { hloop_stop(hevent_loop(t)); }, ms, 1);
+    assert(timer);
+    hloop_run(loop);
+}
+
+MyProtoSharedFrame makeFrame() {
+    MyProtoSharedFrame frame;
+    frame.data = std::make_shared<std::string>(64, 'x');
+    return frame;
+}
+
+// 超出窗口的SACK区间不确认任何消息，也不按区间长度遍历
+void testSackAheadOfWindow() {
+    ReliableMsgManager manager(3, 1000);
+    manager.setWindowConfig(4, 1024 * 1024, 16, 1024 * 1024);
+    std::vector<uint32_t> wire;
+    manager.setTransmitCallback([&](int, const PendingMessage& pending) { wire.push_back(pending.sequence); });
+
+    MyProtoSharedFrame frame = makeFrame();
+    uint32_t seqs[6];
+    for (uint32_t& seq : seqs) {
+        assert(manager.sendReliable(1, frame, &seq));
+    }
+    assert(manager.inFlightCount(1) == 4 && manager.queuedCount(1) == 2);
+
+    // 整体在已发出部分之后：包括排队未发出的序列号和与环形数组下标冲突的序列号
+    manager.processRangeConfirmation(1, seqs[4], seqs[5]);
+    manager.processRangeConfirmation(1, seqs[0] + 8, seqs[0] + 8);
+    assert(manager.inFlightCount(1) == 4 && manager.queuedCount(1) == 2);
+
+    // 跨度接近半个序列号空间的区间也要立即返回
+    auto start = std::chrono::steady_clock::now();
+    manager.processRangeConfirmation(1, seqs[5] + 1, (seqs[5] + 0x3FFFFFF0) | SERVER_SEQUENCE_BASE);
+    assert(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100));
+    assert(manager.inFlightCount(1) == 4);
+
+    // 与已发出部分相交的区间只确认交集，末端截到最后一个已发出的序列号
+    manager.processRangeConfirmation(1, seqs[2], (seqs[3] + 0x1000) | SERVER_SEQUENCE_BASE);
+    assert(manager.inFlightCount(1) == 2 && manager.queuedCount(1) == 2 && wire.size() == 4);
+
+    // 整体在窗口起点之前的区间忽略
+    manager.processRangeConfirmation(1, seqs[0] - 100, seqs[0] - 1);
+    assert(manager.inFlightCount(1) == 2);
+
+    // 窗口起点的消息确认后起点前移，排队的两条发出
+    manager.processRangeConfirmation(1, seqs[0] - 100, seqs[1]);
+    assert(manager.inFlightCount(1) == 2 && manager.queuedCount(1) == 0);
+    assert(wire.size() == 6 && wire[4] == seqs[4] && wire[5] == seqs[5]);
+
+    // 累计确认越过最后发出的序列号时确认全部
+    manager.processCumulativeConfirmation(1, (seqs[5] + 1000) | SERVER_SEQUENCE_BASE);
+    assert(manager.inFlightCount(1) == 0 && manager.queuedCount(1) == 0);
+    assert(frame.data.use_count() == 1);
+}
+
+// 排队的字节数达到上限后拒绝发送，即使条数还远没排满；窗口打开、排队的帧发出后又可以放入
+void testQueuedBytesLimit() {
+    ReliableMsgManager manager(3, 1000);
+    manager.setWindowConfig(64, 64 * 1024, 256, 256 * 1024);
+    std::vector<uint32_t> wire;
+    manager.setTransmitCallback([&](int, const PendingMessage& pending) { wire.push_back(pending.sequence); });
+
+    MyProtoSharedFrame frame;
+    frame.data = std::make_shared<std::string>(100 * 1024, 'x');
+
+    // 第一帧超过在途字节数上限，发出后窗口关闭，后面的帧排队
+    uint32_t first = 0;
+    assert(manager.sendReliable(1, frame, &first));
+    assert(manager.sendReliable(1, frame));
+    assert(manager.sendReliable(1, frame));
+    assert(manager.inFlightCount(1) == 1 && manager.queuedCount(1) == 2);
+
+    // 再排一帧就超过256KB
+    assert(!manager.sendReliable(1, frame));
+    assert(!manager.sendReliable(1, frame));
+    assert(manager.queuedCount(1) == 2 && wire.size() == 1);
+
+    // 确认后排队的一帧发出，又空出位置
+    manager.processConfirmation(1, first);
+    assert(manager.inFlightCount(1) == 1 && manager.queuedCount(1) == 1 && wire.size() == 2);
+    assert(manager.sendReliable(1, frame));
+    assert(!manager.sendReliable(1, frame));
+
+    // 队列为空时超过上限的大帧也能放入一条
+    ReliableMsgManager small(3, 1000);
+    small.setWindowConfig(1, 1024, 16, 1024);
+    small.setTransmitCallback([](int, const PendingMessage&) {});
+    assert(small.sendReliable(1, frame));
+    assert(small.sendReliable(1, frame));
+    assert(!small.sendReliable(1, frame));
+    assert(small.inFlightCount(1) == 1 && small.queuedCount(1) == 1);
+}
+
+// 没有RTT样本时用初始超时，每次重传超时翻倍（加0~25%抖动），不超过上限；
+// 用完重传次数后放弃，窗口释放
+void testRetransmitBackoff() {
+    hloop_t* loop = hloop_new(0);
+    ReliableMsgManager manager(3, 100);
+    manager.setRtoConfig(100, 300); // 检测间隔50毫秒
+    manager.setEventLoop(loop);
+    std::vector<Clock::time_point> sends;
+    manager.setTransmitCallback([&](int, const PendingMessage&) { sends.push_back(Clock::now()); });
+    manager.setRetransmitCallback([&](int, const PendingMessage&) { sends.push_back(Clock::now()); return true; });
+    manager.startTimeoutCheck();
+
+    MyProtoSharedFrame frame = makeFrame();
+    assert(manager.sendReliable(1, frame));
+    runLoop(loop, 1500);
+    manager.stopTimeoutCheck();
+
+    assert(sends.size() == 4);
+    const long long expected[] = { 100, 200, 300 }; // 第三次已达上限
+    for (int i = 0; i < 3; ++i) {
+        long long gap = elapsedMs(sends[i], sends[i + 1]);
+        assert(gap >= expected[i] && gap <= expected[i] * 5 / 4 + 100);
+    }
+    assert(manager.inFlightCount(1) == 0 && frame.data.use_count() == 1);
+    hloop_free(&loop);
+}
+
+// 有RTT样本后按RFC 6298计算超时：srtt + 4 * rttvar，首个样本时为3倍RTT
+void testRtoFromRttSample() {
+    hloop_t* loop = hloop_new(0);
+    ReliableMsgManager manager(3, 1000);
+    manager.setRtoConfig(20, 60000); // 检测间隔10毫秒
+    manager.setEventLoop(loop);
+    uint32_t first = 0;
+    std::vector<Clock::time_point> sends;
+    manager.setTransmitCallback([&](int, const PendingMessage&) { sends.push_back(Clock::now()); });
+    manager.setRetransmitCallback([&](int, const PendingMessage&) { sends.push_back(Clock::now()); return true; });
+    manager.startTimeoutCheck();
+
+    MyProtoSharedFrame frame = makeFrame();
+    assert(manager.sendReliable(1, frame, &first));
+    runLoop(loop, 60);
+    manager.processConfirmation(1, first); // RTT约60毫秒，超时约180毫秒
+    assert(manager.sendReliable(1, frame));
+    runLoop(loop, 400);
+    manager.stopTimeoutCheck();
+
+    assert(sends.size() >= 3);
+    long long gap = elapsedMs(sends[1], sends[2]);
+    assert(gap >= 170 && gap < 400); // 远小于初始超时1000毫秒
+    hloop_free(&loop);
+}
+
+// 客户端被限流时重传回调不写出：不消耗重传次数，不退避，限流解除后照常重传
+void testRetransmitWhileThrottled() {
+    hloop_t* loop = hloop_new(0);
+    ReliableMsgManager manager(3, 100);
+    manager.setRtoConfig(100, 300);
+    manager.setEventLoop(loop);
+    bool throttled = true;
+    int skipped = 0, written = 0;
+    manager.setTransmitCallback([](int, const PendingMessage&) {});
+    manager.setRetransmitCallback([&](int, const PendingMessage& pending) {
+        assert(pending.retransmit_count == written);
+        if (throttled) {
+            ++skipped;
+            return false;
+        }
+        ++written;
+        return true;
+    });
+    manager.startTimeoutCheck();
+
+    MyProtoSharedFrame frame = makeFrame();
+    assert(manager.sendReliable(1, frame));
+    runLoop(loop, 1000);
+    assert(skipped >= 5 && written == 0); // 超过最大重传次数也不放弃
+    assert(manager.inFlightCount(1) == 1);
+
+    throttled = false;
+    runLoop(loop, 1500);
+    manager.stopTimeoutCheck();
+    assert(written == 3 && manager.inFlightCount(1) == 0);
+    hloop_free(&loop);
+}
+
+} // namespace
+
+int main() {
+    testSackAheadOfWindow();
+    testQueuedBytesLimit();
+    testRetransmitBackoff();
+    testRtoFromRttSample();
+    testRetransmitWhileThrottled();
+    std::cout << "reliable_msg_manager_test passed" << std::endl;
+    return 0;
+}
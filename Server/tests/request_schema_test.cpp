@@ -0,0 +1,115 @@
+// 请求模式校验和类型化请求解码的单元测试
+// 编译：g++ -std=c++17 -I.. request_schema_test.cpp ../request_schema.cpp ../typed_request.cpp
+#include "request_schema.h"
+#include "typed_request.h"
+#include <cassert>
+#include <iostream>
+
+namespace {
+
+const uint16_t LOGIN = 1001;
+const uint16_t DETAIL = 2003;
+const uint16_t ADD_USER = 1003;
+
+void registerSchemas() {
+    registerRequestSchema(LOGIN, RequestSchema()
+        .optional("username", SCHEMA_STRING, 8)
+        .optional("password", SCHEMA_STRING, 8));
+    registerRequestSchema(DETAIL, RequestSchema()
+        .required("studentId", SCHEMA_INTEGER));
+    registerRequestSchema(ADD_USER, RequestSchema()
+        .required("username", SCHEMA_STRING)
+        .optional("tags", SCHEMA_ARRAY, 2));
+}
+
+bool validate(uint16_t server, const std::string& body, nlohmann::json* out, std::string& error) {
+    error.clear();
+    return validateRequestBody((const uint8_t*)body.data(), body.size(), 0, findRequestSchema(server), out, error);
+}
+
+MyProtoMsg makeRequest(uint16_t server, const std::string& body, uint8_t flags = 0) {
+    MyProtoMsg msg;
+    msg.head.server = server;
+    msg.head.flags = flags;
+    msg.head.type = 0;
+    msg.rawBody = body;
+    return msg;
+}
+
+// DOM路径：通过校验的请求体与json::parse结果相同，不合法的给出原因
+void testValidateDom() {
+    std::string error;
+    nlohmann::json body;
+    std::string text = R"({"userId":1,"data":{"username":"alice","tags":["a","b"],"extra":{"k":1}}})";
+    assert(validate(ADD_USER, text, &body, error));
+    assert(body == nlohmann::json::parse(text));
+
+    assert(!validate(ADD_USER, R"({"data":{"tags":[]}})", nullptr, error));
+    assert(error == "Missing required field: username");
+    assert(!validate(ADD_USER, R"({"data":{"username":1}})", nullptr, error));
+    assert(error == "Wrong type for field: username");
+    assert(!validate(ADD_USER, R"({"data":{"username":"a","tags":["a","b","c"]}})", nullptr, error));
+    assert(error == "Too many elements in field: tags");
+    assert(!validate(ADD_USER, R"({"data":{"username":"a","bad key":1}})", nullptr, error));
+    assert(error.find("Invalid character in JSON key") == 0);
+    assert(!validate(LOGIN, R"({"data":{"username":"123456789"}})", nullptr, error));
+    assert(error == "String value too long for key: username");
+    assert(!validate(LOGIN, R"([1,2])", nullptr, error));
+    assert(!validate(LOGIN, R"({"data":)", nullptr, error));
+
+    // 空消息体视为空对象，只有必填字段会失败
+    assert(validate(LOGIN, "", &body, error) && body == nlohmann::json::object());
+    assert(!validate(DETAIL, "", nullptr, error));
+
+    // 版本1中字符串形式的data按同一模式校验
+    assert(!validate(ADD_USER, R"({"data":"{\"password\":\"x\"}"})", nullptr, error));
+    assert(error == "Missing required field: username");
+}
+
+// 类型化解码：校验和绑定在同一遍解析中完成
+void testDecodeTyped() {
+    std::string error;
+    LoginRequest login;
+    assert(decodeRequest(makeRequest(LOGIN, R"({"userId":5,"data":{"username":"alice","password":"pw"}})"), login, error));
+    assert(login.userId == 5 && login.username == "alice" && login.password == "pw");
+
+    // 版本1：userId为字符串，data为JSON字符串
+    LoginRequest legacy;
+    assert(decodeRequest(makeRequest(LOGIN, R"({"userId":"7","data":"{\"username\":\"bob\"}"})"), legacy, error));
+    assert(legacy.userId == 7 && legacy.username == "bob" && legacy.password.empty());
+
+    // 模式校验的错误
+    LoginRequest tooLong;
+    assert(!decodeRequest(makeRequest(LOGIN, R"({"data":{"username":"123456789"}})"), tooLong, error));
+    assert(error == "String value too long for key: username");
+    StudentDetailRequest detail;
+    assert(!decodeRequest(makeRequest(DETAIL, R"({"data":{}})"), detail, error));
+    assert(error == "Missing required field: studentId");
+    assert(!decodeRequest(makeRequest(DETAIL, ""), detail, error));
+
+    // 绑定器的错误优先于校验器的通用提示
+    assert(!decodeRequest(makeRequest(DETAIL, R"({"data":{"studentId":99999999999}})"), detail, error));
+    assert(error == "Number out of range for key: studentId");
+    assert(!decodeRequest(makeRequest(LOGIN, R"({"userId":"x1"})"), login, error));
+    assert(error == "Invalid userId: x1");
+
+    assert(decodeRequest(makeRequest(DETAIL, R"({"data":{"studentId":42}})"), detail, error));
+    assert(detail.studentId == 42);
+
+    // MessagePack编码的消息体
+    std::vector<uint8_t> packed = nlohmann::json::to_msgpack(nlohmann::json::parse(R"({"data":{"studentId":7}})"));
+    StudentDetailRequest packedDetail;
+    assert(decodeRequest(makeRequest(DETAIL, std::string(packed.begin(), packed.end()), MY_PROTO_CODEC_MSGPACK),
+                         packedDetail, error));
+    assert(packedDetail.studentId == 7);
+}
+
+} // namespace
+
+int main() {
+    registerSchemas();
+    testValidateDom();
+    testDecodeTyped();
+    std::cout << "request_schema_test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,220 @@
+// 流式响应的单元测试：分批读取、在途分片上限、从写出回调继续读取、连接断开和线程池停止
+// 编译：g++ -std=c++17 -I.. response_stream_test.cpp ../response_stream.cpp ../business_handler.cpp
+#include "response_stream.h"
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// 交给连接处理器的一帧，on_sent由测试决定何时回调（模拟客户端读得慢）
+struct SentFrame {
+    nlohmann::json body;
+    bool last;
+    ChunkSentCallback on_sent;
+};
+
+struct Harness {
+    BusinessHandler handler;
+    std::vector<SentFrame> frames;
+    std::deque<std::function<void()>> tasks;  // 提交到线程池的任务，由测试逐个执行
+    bool executor_running = true;
+    int total_rows = 0;
+    int queries = 0;
+
+    Harness() {
+        handler.setChunkSender([this](int, MyProtoMsg& chunk, bool last, ChunkSentCallback on_sent) {
+            frames.push_back(SentFrame{ chunk.body, last, on_sent });
+            return true;
+        });
+        handler.setTaskExecutor([this](std::function<void()> task) {
+            if (!executor_running) {
+                return false;
+            }
+            tasks.push_back(task);
+            return true;
+        });
+    }
+
+    std::shared_ptr<ResponseStream> create(size_t rows_per_chunk) {
+        MyProtoMsg request;
+        request.head.version = 2;
+        request.head.server = 2001;
+        request.head.sequence = 7;
+        // 游标为下一行的编号，每次查询从游标处继续
+        int cursor = 0;
+        return ResponseStream::create(&handler, 1, request,
+            [](const nlohmann::json& result, MyProtoMsg& frame) { frame.body = result; },
+            [this, cursor](size_t limit, const std::function<void(nlohmann::json& row)>& on_row, std::string&) mutable {
+                queries++;
+                for (size_t i = 0; i < limit && cursor < total_rows; i++) {
+                    nlohmann::json row = { {"id", cursor++} };
+                    on_row(row);
+                }
+                return true;
+            }, rows_per_chunk);
+    }
+
+    // 尚未回调的分片数
+    int inFlight() const {
+        int count = 0;
+        for (const SentFrame& frame : frames) {
+            if (!frame.last && frame.on_sent) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    // 回调最早一个尚未回调的分片
+    bool ackOldest(bool ok) {
+        for (SentFrame& frame : frames) {
+            if (!frame.last && frame.on_sent) {
+                ChunkSentCallback on_sent = frame.on_sent;
+                frame.on_sent = nullptr;
+                on_sent(ok);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool runTask() {
+        if (tasks.empty()) {
+            return false;
+        }
+        std::function<void()> task = tasks.front();
+        tasks.pop_front();
+        task();
+        return true;
+    }
+};
+
+// 结果集大于在途上限时处理函数不等待：响应标记为延迟，后续批次在写出回调后提交，结束标记随最后一帧发出
+void testResumesFromCallbacks() {
+    Harness h;
+    h.total_rows = 1000;
+    std::shared_ptr<ResponseStream> stream = h.create(10);
+
+    MyProtoMsg response;
+    stream->start(response);
+    assert(response.deferred);
+    assert(h.frames.size() == 4);
+    assert(h.tasks.empty());
+
+    // 客户端不读时不再读取，也没有任务占用线程池
+    h.ackOldest(true);
+    assert(h.tasks.empty());
+    h.ackOldest(true);
+    assert(h.tasks.size() == 1);
+
+    int max_in_flight = 0;
+    while (h.runTask() || h.ackOldest(true)) {
+        max_in_flight = std::max(max_in_flight, h.inFlight());
+    }
+    assert(max_in_flight <= 4);
+
+    // 行按顺序、不重复地分布在各分片中，最后一帧是结束标记
+    int next_id = 0;
+    for (size_t i = 0; i + 1 < h.frames.size(); i++) {
+        assert(!h.frames[i].last);
+        assert(h.frames[i].body["chunk"] == static_cast<int>(i));
+        for (const nlohmann::json& row : h.frames[i].body["rows"]) {
+            assert(row["id"] == next_id);
+            next_id++;
+        }
+    }
+    assert(next_id == 1000);
+    const SentFrame& end = h.frames.back();
+    assert(end.last);
+    assert(end.body["success"] == true);
+    assert(end.body["end"] == true);
+    assert(end.body["total"] == 1000);
+    assert(end.body["chunks"] == 100);
+    // 第一次查询读满4个分片，之后每次至少读满两个分片，最后可能有一次空查询
+    assert(h.queries <= 1 + 96 / 2 + 1);
+}
+
+// 第一批就读完时结束标记直接填入响应，不延迟
+void testSmallResultCompletesInline() {
+    Harness h;
+    h.total_rows = 25;
+    std::shared_ptr<ResponseStream> stream = h.create(10);
+
+    MyProtoMsg response;
+    stream->start(response);
+    assert(!response.deferred);
+    assert(response.body["end"] == true);
+    assert(response.body["total"] == 25);
+    assert(response.body["chunks"] == 3);
+    assert(h.frames.size() == 3);
+    assert(h.frames[2].body["rows"].size() == 5);
+    assert(h.tasks.empty());
+}
+
+// 客户端指定的分片行数超过上限时按上限分片，一批查询的行数也随之受限
+void testChunkRowsCapped() {
+    Harness h;
+    h.total_rows = 100000;
+    std::shared_ptr<ResponseStream> stream = h.create(1000000);
+
+    MyProtoMsg response;
+    stream->start(response);
+    assert(response.deferred);
+    assert(h.frames.size() == 4);
+    for (const SentFrame& frame : h.frames) {
+        assert(frame.body["rows"].size() == 1000);
+    }
+}
+
+// 连接断开后不再读取，也不发结束标记
+void testStopsWhenClosed() {
+    Harness h;
+    h.total_rows = 1000;
+    std::shared_ptr<ResponseStream> stream = h.create(10);
+
+    MyProtoMsg response;
+    stream->start(response);
+    assert(response.deferred);
+    while (h.ackOldest(false)) {
+    }
+    assert(h.tasks.empty());
+    assert(h.frames.size() == 4);
+}
+
+// 线程池停止时以失败结束，后面的响应不会一直等待该请求
+void testFailsWhenExecutorStopped() {
+    Harness h;
+    h.total_rows = 1000;
+    std::shared_ptr<ResponseStream> stream = h.create(10);
+
+    MyProtoMsg response;
+    stream->start(response);
+    h.executor_running = false;
+    h.ackOldest(true);
+    h.ackOldest(true);
+    assert(h.frames.size() == 5);
+    assert(h.frames.back().last);
+    assert(h.frames.back().body["success"] == false);
+
+    // 结束后剩余分片的回调不再触发读取
+    h.executor_running = true;
+    while (h.ackOldest(true)) {
+    }
+    assert(h.tasks.empty());
+    assert(h.frames.size() == 5);
+}
+
+}  // namespace
+
+int main() {
+    testResumesFromCallbacks();
+    testSmallResultCompletesInline();
+    testChunkRowsCapped();
+    testStopsWhenClosed();
+    testFailsWhenExecutorStopped();
+    std::cout << "response_stream_test passed" << std::endl;
+    return 0;
+}
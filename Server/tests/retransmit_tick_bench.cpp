@@ -0,0 +1,54 @@
+// 重传超时检测每次触发的开销随在途消息数的变化（基准测试，不做断言）
+// 编译：g++ -std=c++17 -O2 -I.. retransmit_tick_bench.cpp ../reliable_msg_manager.cpp ../timing_wheel.cpp -lhv
+// 每个连接3条在途消息，都远未到期。检测只处理时间轮中到期的连接，
+// 每次触发的耗时应与在途消息总数基本无关
+#include "reliable_msg_manager.h"
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+
+namespace {
+
+const uint32_t RUN_MS = 2000;
+const int CHECK_INTERVAL_MS = 10; // setRtoConfig(20, ...)时的检测间隔
+const int MESSAGES_PER_CONNECTION = 3;
+
+double benchTick(int connections) {
+    hloop_t* loop = hloop_new(0);
+    ReliableMsgManager manager(3, 600000); // 初始超时10分钟，运行期间不会到期
+    manager.setRtoConfig(20, 600000);
+    manager.setEventLoop(loop);
+    manager.setTransmitCallback([](int, const PendingMessage&) {});
+
+    MyProtoSharedFrame frame;
+    frame.data = std::make_shared<std::string>(256, 'x');
+    for (int conn_id = 0; conn_id < connections; ++conn_id) {
+        for (int i = 0; i < MESSAGES_PER_CONNECTION; ++i) {
+            manager.sendReliable(conn_id, frame);
+        }
+    }
+
+    // 事件循环空闲时阻塞在IO等待上，循环线程的CPU时间基本都花在超时检测上
+    manager.startTimeoutCheck();
+    htimer_add(loop, [](htimer_t* t) { hloop_stop(hevent_loop(t)); }, RUN_MS, 1);
+    std::clock_t start = std::clock();
+    hloop_run(loop);
+    std::clock_t cpu = std::clock() - start;
+    manager.stopTimeoutCheck();
+    hloop_free(&loop);
+
+    double ticks = (double)RUN_MS / CHECK_INTERVAL_MS;
+    return cpu * 1e6 / CLOCKS_PER_SEC / ticks;
+}
+
+} // namespace
+
+int main() {
+    std::cout << std::setw(12) << "pending" << std::setw(16) << "us/tick" << std::endl;
+    for (int connections : { 1000, 10000, 50000 }) {
+        double us = benchTick(connections);
+        std::cout << std::setw(12) << connections * MESSAGES_PER_CONNECTION
+                  << std::setw(16) << std::fixed << std::setprecision(2) << us << std::endl;
+    }
+    return 0;
+}
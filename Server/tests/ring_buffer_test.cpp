@@ -0,0 +1,121 @@
+// 环形缓冲区的单元测试：跨越末尾的读写、扩容和缩容
+// 编译：g++ -std=c++17 -I.. ring_buffer_test.cpp ../ring_buffer.cpp
+#include "ring_buffer.h"
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+
+std::string readAll(RingBuffer& buffer) {
+    std::string out;
+    size_t offset = 0;
+    while (offset < buffer.size()) {
+        size_t len = buffer.size() - offset;
+        const uint8_t* data = buffer.segment(offset, len);
+        out.append((const char*)data, len);
+        offset += len;
+    }
+    return out;
+}
+
+// 写位置绕回开头后数据顺序不变，peek把跨越末尾的数据整理为连续
+void testWrapAround() {
+    RingBuffer buffer(16);
+    buffer.append("0123456789", 10);
+    buffer.consume(8);
+    buffer.append("abcdefghij", 10); // 后6字节写到缓冲区开头
+    assert(buffer.capacity() == 16 && buffer.size() == 12);
+
+    size_t len = 12;
+    buffer.segment(0, len);
+    assert(len == 8); // 只到缓冲区末尾
+    assert(readAll(buffer) == "89abcdefghij");
+
+    const uint8_t* data = buffer.peek(12);
+    assert(memcmp(data, "89abcdefghij", 12) == 0);
+    buffer.consume(12);
+    assert(buffer.empty());
+}
+
+// 扩容后跨越末尾的数据按顺序搬到新缓冲区开头
+void testGrowth() {
+    RingBuffer buffer(16);
+    buffer.append("0123456789", 10);
+    buffer.consume(6);
+    buffer.append("abcdefghij", 10);
+    buffer.append("KLMNOPQRSTUVWXYZ", 16);
+    assert(buffer.capacity() == 32 && buffer.size() == 30);
+    assert(readAll(buffer) == "6789abcdefghijKLMNOPQRSTUVWXYZ");
+}
+
+// 大帧读走后不立即缩容：连续16次读取前缓存的数据都很少、且读空时才缩回初始容量，剩余数据保留
+void testShrink() {
+    RingBuffer buffer(16);
+    std::string frame(100, 'f');
+    buffer.append(frame.data(), frame.size());
+    buffer.append("tail", 4);
+    assert(buffer.capacity() == 128);
+
+    buffer.consume(50);
+    assert(buffer.capacity() == 128); // 剩余数据还多，不缩
+    buffer.consume(50);
+    assert(buffer.capacity() == 128 && readAll(buffer) == "tail");
+
+    for (int i = 1; i < 16; ++i) {
+        buffer.consume(4);
+        assert(buffer.capacity() == 128); // 空闲读取不足16次
+        buffer.append("tail", 4);
+    }
+    buffer.consume(2);
+    assert(buffer.capacity() == 128 && readAll(buffer) == "il"); // 第16次，但没有读空
+    buffer.consume(2);
+    assert(buffer.capacity() == 16 && buffer.empty());
+
+    buffer.append("next", 4);
+    assert(readAll(buffer) == "next");
+    buffer.append(frame.data(), frame.size());
+    assert(buffer.capacity() == 128);
+    buffer.clear();
+    assert(buffer.capacity() == 16 && buffer.empty()); // 出错重置时直接缩容
+}
+
+// 大帧和小帧交替到达时容量保持不变，不会每个大帧都重新扩容；之后只有小帧时缩回
+void testOscillation() {
+    RingBuffer buffer(16);
+    std::string large(100, 'L');
+    for (int round = 0; round < 100; ++round) {
+        buffer.append(large.data(), large.size());
+        assert(buffer.capacity() == 128);
+        buffer.consume(large.size());
+        for (int i = 0; i < 3; ++i) {
+            buffer.append("smal", 4);
+            buffer.consume(4);
+            assert(buffer.capacity() == 128);
+        }
+    }
+
+    // 最后一轮的3个小帧已经算作空闲读取，再有13个小帧后缩回
+    for (int i = 0; i < 12; ++i) {
+        buffer.append("smal", 4);
+        buffer.consume(4);
+    }
+    assert(buffer.capacity() == 128);
+    buffer.append("smal", 4);
+    buffer.consume(4);
+    assert(buffer.capacity() == 16);
+    buffer.append("smal", 4);
+    assert(readAll(buffer) == "smal");
+}
+
+} // namespace
+
+int main() {
+    testWrapAround();
+    testGrowth();
+    testShrink();
+    testOscillation();
+    std::cout << "ring_buffer_test passed" << std::endl;
+    return 0;
+}
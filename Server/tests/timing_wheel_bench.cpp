@@ -0,0 +1,144 @@
+// 空闲超时跟踪的基准测试：时间轮 与 每个连接一个htimer 在不同连接数下的登记、刷新、取消耗时（不做断言）
+// 编译：g++ -std=c++17 -O2 -I.. timing_wheel_bench.cpp ../timing_wheel.cpp -lhv
+// 每个连接登记一次空闲超时，每轮所有连接按随机顺序各刷新一次（收到数据），共REFRESH_ROUNDS轮，最后全部取消。
+// htimer放在事件循环的定时器堆中，刷新（htimer_reset）是堆的删除加插入，随连接数对数增长；
+// 时间轮的刷新是一次哈希查找加链表摘除、插入，没有对数项（连接数大时的增长来自缓存未命中）。
+// 时间轮另外列出每格推进的耗时（没有条目到期时）
+#include "timing_wheel.h"
+#include <hv/hloop.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const uint32_t TIMEOUT_MS = 60000;  // 空闲超时，测试期间不会到期
+const uint32_t TICK_MS = 100;       // 与连接处理器的时间轮一致
+const int REFRESH_ROUNDS = 10;
+const int ADVANCE_TICKS = 500;   // 推进50秒，最后一次刷新的超时还没到
+
+struct Result {
+    double schedule_ns;  // 每个连接登记的耗时
+    double refresh_ns;   // 每次刷新的耗时
+    double cancel_ns;    // 每个连接取消的耗时
+    double advance_us;   // 每格推进的耗时（只有时间轮）
+};
+
+double nsPerOp(Clock::time_point start, size_t ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops;
+}
+
+std::vector<int> shuffledIds(int connections, std::mt19937& rng) {
+    std::vector<int> ids(connections);
+    for (int i = 0; i < connections; ++i) {
+        ids[i] = i;
+    }
+    std::shuffle(ids.begin(), ids.end(), rng);
+    return ids;
+}
+
+Result benchWheel(int connections) {
+    std::mt19937 rng(1);
+    Result result = Result();
+    TimingWheel wheel(TICK_MS, 1024);
+    uint64_t now = 0;
+
+    Clock::time_point start = Clock::now();
+    for (int id = 0; id < connections; ++id) {
+        wheel.schedule(id, now + TIMEOUT_MS);
+    }
+    result.schedule_ns = nsPerOp(start, connections);
+
+    double refresh_total = 0;
+    for (int round = 0; round < REFRESH_ROUNDS; ++round) {
+        now += 1000;
+        std::vector<int> ids = shuffledIds(connections, rng);
+        start = Clock::now();
+        for (int id : ids) {
+            wheel.schedule(id, now + TIMEOUT_MS);
+        }
+        refresh_total += nsPerOp(start, connections);
+    }
+    result.refresh_ns = refresh_total / REFRESH_ROUNDS;
+
+    std::vector<int> expired;
+    start = Clock::now();
+    for (int i = 0; i < ADVANCE_TICKS; ++i) {
+        now += TICK_MS;
+        wheel.advance(now, expired);
+    }
+    result.advance_us = nsPerOp(start, ADVANCE_TICKS) / 1000;
+    if (!expired.empty()) {
+        std::cerr << "unexpected expiry: " << expired.size() << std::endl;
+    }
+
+    std::vector<int> ids = shuffledIds(connections, rng);
+    start = Clock::now();
+    for (int id : ids) {
+        wheel.cancel(id);
+    }
+    result.cancel_ns = nsPerOp(start, connections);
+    return result;
+}
+
+Result benchHtimer(int connections) {
+    std::mt19937 rng(1);
+    Result result = Result();
+    hloop_t* loop = hloop_new(0);
+    std::vector<htimer_t*> timers(connections);
+
+    Clock::time_point start = Clock::now();
+    for (int id = 0; id < connections; ++id) {
+        timers[id] = htimer_add(loop, [](htimer_t*) {}, TIMEOUT_MS, 1);
+    }
+    result.schedule_ns = nsPerOp(start, connections);
+
+    double refresh_total = 0;
+    for (int round = 0; round < REFRESH_ROUNDS; ++round) {
+        std::vector<int> ids = shuffledIds(connections, rng);
+        start = Clock::now();
+        for (int id : ids) {
+            htimer_reset(timers[id], 0);
+        }
+        refresh_total += nsPerOp(start, connections);
+    }
+    result.refresh_ns = refresh_total / REFRESH_ROUNDS;
+
+    std::vector<int> ids = shuffledIds(connections, rng);
+    start = Clock::now();
+    for (int id : ids) {
+        htimer_del(timers[id]);
+    }
+    result.cancel_ns = nsPerOp(start, connections);
+    hloop_free(&loop);
+    return result;
+}
+
+void report(const char* name, int connections, const Result& result, bool has_advance) {
+    std::cout << std::setw(12) << name << std::setw(12) << connections << std::fixed << std::setprecision(1)
+              << std::setw(14) << result.schedule_ns << std::setw(14) << result.refresh_ns
+              << std::setw(14) << result.cancel_ns;
+    if (has_advance) {
+        std::cout << std::setw(14) << std::setprecision(2) << result.advance_us;
+    } else {
+        std::cout << std::setw(14) << "-";
+    }
+    std::cout << std::endl;
+}
+
+} // namespace
+
+int main() {
+    std::cout << std::setw(12) << "tracker" << std::setw(12) << "conns" << std::setw(14) << "schedule ns"
+              << std::setw(14) << "refresh ns" << std::setw(14) << "cancel ns" << std::setw(14) << "us/tick" << std::endl;
+    for (int connections : { 10000, 50000, 100000 }) {
+        report("htimer", connections, benchHtimer(connections), false);
+        report("wheel", connections, benchWheel(connections), true);
+    }
+    return 0;
+}
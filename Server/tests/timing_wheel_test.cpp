@@ -0,0 +1,102 @@
+// 时间轮的单元测试：到期、取消、刷新、超过一圈的到期时间和长时间停顿
+// 编译：g++ -std=c++17 -I.. timing_wheel_test.cpp ../timing_wheel.cpp
+#include "timing_wheel.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+std::vector<int> advance(TimingWheel& wheel, uint64_t now_ms) {
+    std::vector<int> expired;
+    wheel.advance(now_ms, expired);
+    std::sort(expired.begin(), expired.end());
+    return expired;
+}
+
+// 到期时间之前不取出，到期后取出一次
+void testExpire() {
+    TimingWheel wheel(10, 8);
+    std::vector<int> ignored;
+    wheel.advance(1000, ignored);
+    wheel.schedule(1, 1025);
+    wheel.schedule(2, 1030);
+    wheel.schedule(3, 1030);
+    assert(advance(wheel, 1020).empty());
+    assert(advance(wheel, 1025) == std::vector<int>({ 1 }));
+    assert(advance(wheel, 1029).empty()); // 同一格里还没到期的条目留下
+    assert(advance(wheel, 1030) == std::vector<int>({ 2, 3 }));
+    assert(wheel.size() == 0);
+    assert(advance(wheel, 2000).empty());
+}
+
+// 取消的条目不再到期，刷新后按新的到期时间
+void testCancelAndReschedule() {
+    TimingWheel wheel(10, 8);
+    std::vector<int> ignored;
+    wheel.advance(0, ignored);
+    wheel.schedule(1, 50);
+    wheel.schedule(2, 50);
+    wheel.schedule(3, 50);
+    wheel.cancel(2);
+    wheel.cancel(42); // 不存在的ID
+    wheel.schedule(3, 200);
+    assert(wheel.size() == 2);
+    assert(advance(wheel, 100) == std::vector<int>({ 1 }));
+    assert(advance(wheel, 199).empty());
+    assert(advance(wheel, 200) == std::vector<int>({ 3 }));
+}
+
+// 超过一圈的到期时间与近的条目落在同一槽，转到时比较到期时间，不会提前取出
+void testMultipleRounds() {
+    TimingWheel wheel(10, 8); // 一圈80毫秒
+    std::vector<int> ignored;
+    wheel.advance(0, ignored);
+    wheel.schedule(1, 30);
+    wheel.schedule(2, 30 + 80);
+    wheel.schedule(3, 30 + 3 * 80);
+    for (uint64_t now = 10; now <= 400; now += 10) {
+        std::vector<int> expired = advance(wheel, now);
+        if (now == 30) assert(expired == std::vector<int>({ 1 }));
+        else if (now == 110) assert(expired == std::vector<int>({ 2 }));
+        else if (now == 270) assert(expired == std::vector<int>({ 3 }));
+        else assert(expired.empty());
+    }
+}
+
+// 停顿超过一圈后一次推进取出全部已到期的条目，未到期的留下
+void testLongStall() {
+    TimingWheel wheel(10, 8);
+    std::vector<int> ignored;
+    wheel.advance(0, ignored);
+    for (int id = 0; id < 20; ++id) {
+        wheel.schedule(id, 10 + id * 10);
+    }
+    wheel.schedule(100, 1000);
+    std::vector<int> expired = advance(wheel, 500);
+    assert(expired.size() == 20 && expired.front() == 0 && expired.back() == 19);
+    assert(wheel.size() == 1);
+    assert(advance(wheel, 1000) == std::vector<int>({ 100 }));
+}
+
+// 推进后才登记的已过期条目在下一次推进时取出
+void testScheduleInPast() {
+    TimingWheel wheel(10, 8);
+    std::vector<int> ignored;
+    wheel.advance(500, ignored);
+    wheel.schedule(7, 100);
+    assert(advance(wheel, 500) == std::vector<int>({ 7 }));
+}
+
+} // namespace
+
+int main() {
+    testExpire();
+    testCancelAndReschedule();
+    testMultipleRounds();
+    testLongStall();
+    testScheduleInPast();
+    std::cout << "timing_wheel_test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,127 @@
+// 请求解码的基准测试：构建DOM后按键取值 与 SAX直接写入类型化请求 的耗时和堆分配次数（不做断言）
+// 编译：g++ -std=c++17 -O2 -I.. typed_request_bench.cpp ../request_schema.cpp ../typed_request.cpp
+#include "request_schema.h"
+#include "typed_request.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <new>
+
+namespace {
+size_t g_allocations = 0;
+}
+
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+const int ITERATIONS = 200000;
+
+struct Result {
+    double ns;
+    double allocations;
+};
+
+template <typename F>
+Result measure(F decode) {
+    decode(); // 预热
+    size_t allocations = g_allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        decode();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return Result{ std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS,
+                   (double)(g_allocations - allocations) / ITERATIONS };
+}
+
+void report(const char* name, const Result& dom, const Result& typed) {
+    std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << dom.ns << std::setw(12) << dom.allocations
+              << std::setw(12) << typed.ns << std::setw(14) << typed.allocations << std::endl;
+}
+
+MyProtoMsg makeRequest(uint16_t server, const std::string& body) {
+    MyProtoMsg msg;
+    msg.head.server = server;
+    msg.head.flags = 0;
+    msg.head.type = 0;
+    msg.rawBody = body;
+    return msg;
+}
+
+// 原来的路径：解码器构建DOM并校验，处理函数再用contains和operator[]取值
+template <typename Read>
+Result measureDom(const MyProtoMsg& msg, Read read) {
+    return measure([&]() {
+        nlohmann::json body;
+        std::string error;
+        validateRequestBody((const uint8_t*)msg.rawBody.data(), msg.rawBody.size(), msg.head.flags,
+                            findRequestSchema(msg.head.server), &body, error);
+        read(body);
+    });
+}
+
+} // namespace
+
+int main() {
+    registerRequestSchema(1001, RequestSchema()
+        .optional("username", SCHEMA_STRING, 64)
+        .optional("password", SCHEMA_STRING, 128));
+    registerRequestSchema(2001, RequestSchema()
+        .optional("page", SCHEMA_INTEGER)
+        .optional("pageSize", SCHEMA_INTEGER)
+        .optional("stream", SCHEMA_BOOLEAN)
+        .optional("chunkRows", SCHEMA_INTEGER));
+    registerRequestSchema(2003, RequestSchema()
+        .required("studentId", SCHEMA_INTEGER));
+
+    MyProtoMsg login = makeRequest(1001, R"({"userId":0,"data":{"username":"administrator","password":"a-rather-long-password-123"}})");
+    MyProtoMsg list = makeRequest(2001, R"({"userId":12,"data":{"page":3,"pageSize":50,"stream":false}})");
+    MyProtoMsg detail = makeRequest(2003, R"({"userId":12,"data":{"studentId":20230001}})");
+
+    std::cout << std::left << std::setw(10) << "request" << std::right
+              << std::setw(12) << "dom ns" << std::setw(12) << "dom allocs"
+              << std::setw(12) << "typed ns" << std::setw(14) << "typed allocs" << std::endl;
+
+    std::string error;
+    report("1001",
+        measureDom(login, [](const nlohmann::json& body) {
+            const nlohmann::json& data = body["data"];
+            std::string username = data.contains("username") ? data["username"].get<std::string>() : "";
+            std::string password = data.contains("password") ? data["password"].get<std::string>() : "";
+        }),
+        measure([&]() { LoginRequest req; decodeRequest(login, req, error); }));
+    report("2001",
+        measureDom(list, [](const nlohmann::json& body) {
+            const nlohmann::json& data = body["data"];
+            volatile int page = data.contains("page") ? data["page"].get<int>() : 1;
+            volatile int pageSize = data.contains("pageSize") ? data["pageSize"].get<int>() : 10;
+            volatile bool stream = data.contains("stream") ? data["stream"].get<bool>() : false;
+            (void)page; (void)pageSize; (void)stream;
+        }),
+        measure([&]() { StudentListRequest req; decodeRequest(list, req, error); }));
+    report("2003",
+        measureDom(detail, [](const nlohmann::json& body) {
+            volatile int id = body["data"]["studentId"].get<int>();
+            (void)id;
+        }),
+        measure([&]() { StudentDetailRequest req; decodeRequest(detail, req, error); }));
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "timing_wheel.h"
+
+TimingWheel::TimingWheel(uint32_t tick_ms, size_t slot_count)
+    : tick_ms_(tick_ms ? tick_ms : 1), current_tick_(0), started_(false) {
+    size_t count = 1;
+    while (count < slot_count) {
+        count <<= 1;
+    }
+    slots_.assign(count, nullptr);
+}
+
+void TimingWheel::link(Node* node) {
+    // 已经扫过的格不会再回头，到期时间早于当前格的条目放到当前格
+    uint64_t tick = node->deadline / tick_ms_;
+    if (started_ && tick < current_tick_) {
+        tick = current_tick_;
+    }
+    node->slot = tick & (slots_.size() - 1);
+    node->prev = nullptr;
+    node->next = slots_[node->slot];
+    if (node->next) {
+        node->next->prev = node;
+    }
+    slots_[node->slot] = node;
+}
+
+void TimingWheel::unlink(Node* node) {
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        slots_[node->slot] = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    }
+    node->prev = node->next = nullptr;
+}
+
+void TimingWheel::schedule(int id, uint64_t deadline_ms) {
+    auto result = nodes_.emplace(id, Node());
+    Node* node = &result.first->second;
+    if (result.second) {
+        node->id = id;
+    } else {
+        unlink(node);
+    }
+    node->deadline = deadline_ms;
+    link(node);
+}
+
+void TimingWheel::cancel(int id) {
+    auto it = nodes_.find(id);
+    if (it == nodes_.end()) {
+        return;
+    }
+    unlink(&it->second);
+    nodes_.erase(it);
+}
+
+void TimingWheel::advance(uint64_t now_ms, std::vector<int>& expired) {
+    uint64_t now_tick = now_ms / tick_ms_;
+    if (!started_) {
+        // 第一次推进时从当前格开始，把之前已到期的条目也一并扫到
+        current_tick_ = now_tick > slots_.size() ? now_tick - slots_.size() : 0;
+        started_ = true;
+    }
+    if (now_tick < current_tick_) {
+        return;
+    }
+
+    // 停顿超过一圈时每个槽只需扫描一次
+    uint64_t first = current_tick_;
+    if (now_tick - first >= slots_.size()) {
+        first = now_tick - slots_.size() + 1;
+    }
+
+    for (uint64_t tick = first; tick <= now_tick; ++tick) {
+        Node* node = slots_[tick & (slots_.size() - 1)];
+        while (node) {
+            Node* next = node->next;
+            // 同一槽中还有更晚几圈才到期的条目，留在原处
+            if (node->deadline <= now_ms) {
+                int id = node->id;
+                unlink(node);
+                nodes_.erase(id);
+                expired.push_back(id);
+            }
+            node = next;
+        }
+    }
+    // 当前格里晚于now_ms的条目下次推进时还要再扫一遍
+    current_tick_ = now_tick;
+}
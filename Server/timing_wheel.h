@@ -0,0 +1,47 @@
+#ifndef __TIMING_WHEEL_H__
+#define __TIMING_WHEEL_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <unordered_map>
+
+// 哈希时间轮，按连接ID跟踪到期时间。每个事件循环持有一个，由一个周期定时器推进，
+// 取代每个连接各自的htimer。刷新到期时间和取消都是O(1)，到期的条目按槽批量取出。
+// 超过一圈的到期时间直接放入对应槽，扫描时比较到期时间决定是否取出。
+class TimingWheel {
+private:
+    struct Node {
+        int id;
+        uint64_t deadline;  // 到期时间（毫秒）
+        size_t slot;        // 所在槽
+        Node* prev;
+        Node* next;
+    };
+
+    uint32_t tick_ms_;                      // 每一格的时间跨度（毫秒）
+    std::vector<Node*> slots_;              // 每个槽的链表头，槽数为2的幂
+    std::unordered_map<int, Node> nodes_;   // 连接ID到节点，节点地址在rehash后保持不变
+    uint64_t current_tick_;                 // 已推进到的格
+    bool started_;
+
+    void link(Node* node);
+    void unlink(Node* node);
+
+public:
+    TimingWheel(uint32_t tick_ms = 100, size_t slot_count = 1024);
+
+    // 设置（或刷新）id的到期时间
+    void schedule(int id, uint64_t deadline_ms);
+
+    // 取消id的到期时间
+    void cancel(int id);
+
+    // 推进到now_ms，把已到期的id追加到expired并从时间轮中移除
+    void advance(uint64_t now_ms, std::vector<int>& expired);
+
+    size_t size() const { return nodes_.size(); }
+    uint32_t tickMs() const { return tick_ms_; }
+};
+
+#endif // __TIMING_WHEEL_H__
@@ -0,0 +1,223 @@
+#include "typed_request.h"
+#include "request_schema.h"
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+
+namespace {
+
+// 把请求体的SAX事件直接写入绑定的字段，不构建DOM。
+// 顶层只取userId和data，data对象内按字段表写入，其余值跳过。
+// 事件经请求模式校验器（request_schema.h）转发而来，键名字符集、字符串长度和必填字段由它检查
+class TypedRequestSax : public nlohmann::json_sax<json> {
+public:
+    // rootIsData为true时根对象本身就是data（版本1中字符串形式的data）
+    TypedRequestSax(TypedRequestBase& base, const RequestFieldTable& fields, bool rootIsData)
+        : base_(base), fields_(fields), rootIsData_(rootIsData) {}
+
+    const std::string& error() const { return error_; }
+
+    bool null() override {
+        return checkRoot();
+    }
+
+    bool boolean(bool val) override {
+        if (!checkRoot()) return false;
+        const RequestFieldTable::Field* field = dataField();
+        if (!field) return true;
+        if (field->kind != RequestFieldTable::BOOL) return typeError();
+        *static_cast<bool*>(field->target) = val;
+        return true;
+    }
+
+    bool number_integer(number_integer_t val) override {
+        if (!checkRoot()) return false;
+        return setInteger(val, val < 0);
+    }
+
+    bool number_unsigned(number_unsigned_t val) override {
+        if (!checkRoot()) return false;
+        return setInteger(static_cast<long long>(val > (number_unsigned_t)LLONG_MAX ? LLONG_MAX : val), false);
+    }
+
+    bool number_float(number_float_t val, const string_t&) override {
+        if (!checkRoot()) return false;
+        if (val < (number_float_t)LLONG_MIN || val > (number_float_t)LLONG_MAX) {
+            return fail("Number out of range for key: " + key_);
+        }
+        return setInteger(static_cast<long long>(val), val < 0);
+    }
+
+    bool string(string_t& val) override {
+        if (!checkRoot()) return false;
+        if (atTopLevel()) {
+            if (key_ == "userId") {
+                // 老客户端以字符串形式传userId
+                char* end = nullptr;
+                long id = strtol(val.c_str(), &end, 10);
+                if (val.empty() || *end != '\0' || id < INT_MIN || id > INT_MAX) {
+                    return fail("Invalid userId: " + val);
+                }
+                base_.userId = (int)id;
+            }
+            return true; // 版本1字符串形式的data由校验器解析后交给另一个绑定器
+        }
+        const RequestFieldTable::Field* field = dataField();
+        if (!field) return true;
+        if (field->kind != RequestFieldTable::STRING) return typeError();
+        *static_cast<std::string*>(field->target) = std::move(val);
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        if (depth_ == 0 && rootIsData_) {
+            dataDepth_ = 1;
+        }
+        else if (atTopLevel() && key_ == "data" && dataDepth_ == 0) {
+            dataDepth_ = depth_ + 1;
+        }
+        ++depth_;
+        return true;
+    }
+
+    bool key(string_t& val) override {
+        key_ = std::move(val);
+        return true;
+    }
+
+    bool end_object() override {
+        if (depth_ == dataDepth_) {
+            dataDepth_ = -1; // data只取第一次出现的对象
+        }
+        --depth_;
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        if (!checkRoot()) return false;
+        ++depth_;
+        return true;
+    }
+
+    bool end_array() override {
+        --depth_;
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override {
+        return fail(std::string("Request body parse error at ") + std::to_string(position) + ": " + ex.what());
+    }
+
+private:
+    TypedRequestBase& base_;
+    const RequestFieldTable& fields_;
+    bool rootIsData_;
+    int depth_ = 0;       // 当前所在容器的嵌套深度
+    int dataDepth_ = 0;   // data对象成员所在的深度，0为还未遇到
+    std::string key_;     // 最近的键名，即下一个值所属的字段
+    std::string error_;
+
+    bool fail(const std::string& message) {
+        error_ = message;
+        return false;
+    }
+
+    bool typeError() {
+        return fail("Wrong type for field: " + key_);
+    }
+
+    // 根必须是对象
+    bool checkRoot() {
+        return depth_ > 0 || fail("Request body must be an object");
+    }
+
+    bool atTopLevel() const {
+        return !rootIsData_ && depth_ == 1;
+    }
+
+    const RequestFieldTable::Field* dataField() const {
+        return depth_ == dataDepth_ ? fields_.find(key_) : nullptr;
+    }
+
+    bool setInteger(long long val, bool negative) {
+        if (atTopLevel()) {
+            if (key_ == "userId") {
+                if (val < INT_MIN || val > INT_MAX) return fail("Invalid userId");
+                base_.userId = (int)val;
+            }
+            return true;
+        }
+        const RequestFieldTable::Field* field = dataField();
+        if (!field) return true;
+        switch (field->kind) {
+        case RequestFieldTable::INT:
+            if (val < INT_MIN || val > INT_MAX) return fail("Number out of range for key: " + key_);
+            *static_cast<int*>(field->target) = (int)val;
+            return true;
+        case RequestFieldTable::SIZE:
+            if (negative) return fail("Number out of range for key: " + key_);
+            *static_cast<size_t*>(field->target) = (size_t)val;
+            return true;
+        default:
+            return typeError();
+        }
+    }
+};
+
+} // namespace
+
+const RequestFieldTable::Field* RequestFieldTable::find(const std::string& key) const {
+    for (const Field& field : fields_) {
+        if (key == field.key) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+bool decodeTypedRequest(const MyProtoMsg& msg, TypedRequestBase& base,
+                        const RequestFieldTable& fields, std::string& error) {
+    // 校验与绑定在同一遍解析中完成；空消息体按全部字段取默认值，只检查必填字段
+    TypedRequestSax sax(base, fields, false);
+    TypedRequestSax dataSax(base, fields, true);
+    if (!validateRequestBody(reinterpret_cast<const uint8_t*>(msg.rawBody.data()), msg.rawBody.size(),
+                             msg.head.flags, findRequestSchema(msg.head.server), &sax, &dataSax, error)) {
+        // 绑定器的类型错误比校验器的通用提示更具体
+        if (!sax.error().empty()) {
+            error = sax.error();
+        }
+        else if (!dataSax.error().empty()) {
+            error = dataSax.error();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool decodeRequest(const MyProtoMsg& msg, LoginRequest& req, std::string& error) {
+    RequestFieldTable fields;
+    fields.bind("username", req.username)
+          .bind("password", req.password);
+    return decodeTypedRequest(msg, req, fields, error);
+}
+
+bool decodeRequest(const MyProtoMsg& msg, StudentListRequest& req, std::string& error) {
+    RequestFieldTable fields;
+    fields.bind("page", req.page)
+          .bind("pageSize", req.pageSize)
+          .bind("stream", req.stream)
+          .bind("chunkRows", req.chunkRows);
+    return decodeTypedRequest(msg, req, fields, error);
+}
+
+bool decodeRequest(const MyProtoMsg& msg, StudentSearchRequest& req, std::string& error) {
+    RequestFieldTable fields;
+    fields.bind("keyword", req.keyword);
+    return decodeTypedRequest(msg, req, fields, error);
+}
+
+bool decodeRequest(const MyProtoMsg& msg, StudentDetailRequest& req, std::string& error) {
+    RequestFieldTable fields;
+    fields.bind("studentId", req.studentId);
+    return decodeTypedRequest(msg, req, fields, error);
+}
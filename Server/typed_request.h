@@ -0,0 +1,79 @@
+#ifndef __TYPED_REQUEST_H__
+#define __TYPED_REQUEST_H__
+
+#include <string>
+#include <vector>
+#include "MyProto.h"
+
+// 热点接口的类型化请求：消息体不构建json DOM，由SAX事件直接写入结构体字段。
+// 这些服务的消息体解码器不做校验，按服务号注册的请求模式（request_schema.h）
+// 在绑定的同一遍SAX解析中校验。
+
+// 所有请求共有的字段（位于消息体顶层）
+struct TypedRequestBase {
+    int userId = 0; // 当前用户ID，未登录为0
+};
+
+// 1001 登录
+struct LoginRequest : TypedRequestBase {
+    std::string username;
+    std::string password;
+};
+
+// 2001 学生列表
+struct StudentListRequest : TypedRequestBase {
+    int page = 1;
+    int pageSize = 10;
+    bool stream = false;     // 是否流式返回全部学生
+    size_t chunkRows = 200;  // 流式模式下每个分片的行数，由客户端指定，服务器限制在1000以内
+};
+
+// 2002 搜索学生
+struct StudentSearchRequest : TypedRequestBase {
+    std::string keyword;
+};
+
+// 2003 学生详情
+struct StudentDetailRequest : TypedRequestBase {
+    int studentId = 0;
+};
+
+// data对象中字段到结构体成员的绑定表
+class RequestFieldTable {
+public:
+    enum Kind { STRING, INT, SIZE, BOOL };
+    struct Field {
+        const char* key;
+        Kind kind;
+        void* target;
+    };
+
+    RequestFieldTable& bind(const char* key, std::string& target) { return add(key, STRING, &target); }
+    RequestFieldTable& bind(const char* key, int& target) { return add(key, INT, &target); }
+    RequestFieldTable& bind(const char* key, size_t& target) { return add(key, SIZE, &target); }
+    RequestFieldTable& bind(const char* key, bool& target) { return add(key, BOOL, &target); }
+
+    // 按键名查找，未绑定的字段返回nullptr（解析时跳过）
+    const Field* find(const std::string& key) const;
+
+private:
+    std::vector<Field> fields_;
+
+    RequestFieldTable& add(const char* key, Kind kind, void* target) {
+        fields_.push_back(Field{ key, kind, target });
+        return *this;
+    }
+};
+
+// 按消息头中的编码方式解析原始消息体（msg.rawBody），顶层userId写入base，
+// data中的字段按表写入；版本1中以字符串形式存放的data在校验时一并绑定。
+// 校验或绑定失败时返回false，error为原因
+bool decodeTypedRequest(const MyProtoMsg& msg, TypedRequestBase& base,
+                        const RequestFieldTable& fields, std::string& error);
+
+bool decodeRequest(const MyProtoMsg& msg, LoginRequest& req, std::string& error);
+bool decodeRequest(const MyProtoMsg& msg, StudentListRequest& req, std::string& error);
+bool decodeRequest(const MyProtoMsg& msg, StudentSearchRequest& req, std::string& error);
+bool decodeRequest(const MyProtoMsg& msg, StudentDetailRequest& req, std::string& error);
+
+#endif // __TYPED_REQUEST_H__
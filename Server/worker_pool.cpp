@@ -0,0 +1,81 @@
+#include "worker_pool.h"
+#include <iostream>
+
+WorkerPool::WorkerPool() : stop_(false) {
+}
+
+WorkerPool::~WorkerPool() {
+    stop();
+}
+
+void WorkerPool::start(int num_threads) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = false;
+    }
+    for (int i = 0; i < num_threads; ++i) {
+        workers_.emplace_back(&WorkerPool::workerThread, this);
+    }
+    std::cout << "WorkerPool started with " << num_threads << " worker threads" << std::endl;
+}
+
+void WorkerPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_ && workers_.empty()) {
+            return;
+        }
+        stop_ = true;
+    }
+    condition_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+    std::cout << "WorkerPool stopped" << std::endl;
+}
+
+bool WorkerPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) {
+            return false;
+        }
+        tasks_.push(std::move(task));
+    }
+    condition_.notify_one();
+    return true;
+}
+
+size_t WorkerPool::pendingTasks() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+void WorkerPool::workerThread() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+
+            // 停止后把队列中剩余的任务执行完再退出
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << "Exception in worker task: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Unknown exception in worker task" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// 业务工作线程池，承接会阻塞的业务处理（数据库访问等），避免占用事件循环线程
+class WorkerPool {
+private:
+    std::vector<std::thread> workers_;          // 工作线程
+    std::queue<std::function<void()>> tasks_;   // 待执行任务队列
+    std::mutex mutex_;                          // 保护任务队列
+    std::condition_variable condition_;         // 任务到达通知
+    bool stop_;                                 // 停止标志
+
+    void workerThread();
+
+public:
+    WorkerPool();
+    ~WorkerPool();
+
+    // 启动指定数量的工作线程
+    void start(int num_threads);
+
+    // 停止线程池，已提交的任务会先执行完
+    void stop();
+
+    // 提交任务，线程池已停止时返回false
+    bool submit(std::function<void()> task);
+
+    // 当前排队中的任务数
+    size_t pendingTasks();
+
+    // 工作线程数
+    size_t size() const { return workers_.size(); }
+};
+
+#endif // __WORKER_POOL_H__